@@ -8,6 +8,29 @@
 #include "objects.h"
 #include "circularBuffer.h"
 #include "textLabel.h"
+#include "vertexBatch.h"
+#include "circle.h"
+#include "discSprite.h"
+#include "densityMap.h"
+#include "threadPool.h"
+#include "spatialGrid.h"
+#include "quadtree.h"
+#include "profiler.h"
+#include "traceRecorder.h"
+#include "options.h"
+#include "memoryStats.h"
+#include "frameArena.h"
+#include "perfCounters.h"
+#include "benchmark.h"
+#include "renderScale.h"
+#include "qualityGovernor.h"
+#include "scenario.h"
+#include "generators.h"
+#include "checkpoint.h"
+#include "frameCapture.h"
+#include "sceneRender.h"
+#include "trajectory.h"
+#include "physics.h"
 
 /* We will use this renderer to draw into this window every frame. */
 static SDL_Window *window = NULL;
@@ -20,6 +43,31 @@ static TTF_Font *font = NULL;
 Uint64 lastTime;
 struct ObjectList ObjectContainer;
 struct TextLabelList TextContainer;
+/* Scratch memory of the current frame, reset at the top of SDL_AppIterate */
+static struct FrameArena FrameArena;
+#define FRAME_ARENA_SIZE (4 * 1024 * 1024)
+
+/* Trails and bodies of the visible objects, batched into one draw call per kind every frame */
+static struct SceneRenderer Scene;
+static struct DiscAtlas DiscAtlas;
+static struct DensityMap DensityMap;
+static struct ThreadPool WorkerPool;
+/* Offscreen target the scene is drawn into below native resolution, text is drawn over it afterwards */
+static struct RenderScale SceneScale;
+
+/* Index of object and trail bounds, rebuilt whenever objects move, and the objects it found in view this frame (in the frame arena) */
+static struct SpatialGrid ObjectGrid;
+static struct IndexList VisibleObjects;
+/* Bodies only, walked by the automatic mode to merge far away clusters */
+static struct Quadtree ObjectTree;
+static int objectIndexDirty = 1;
+/* Toggled with C, quadtree nodes smaller than aggregatePixels on screen are drawn as one glyph */
+static int aggregateClusters = 1;
+static float aggregatePixels = 2.0f;
+
+/* Physics steps per frame. The quality governor moves this, and the trail length and level of detail thresholds of the scene */
+static int physicsSubsteps = 1;
+static struct QualityGovernor QualityGovernor;
 
 int WindowHeight;
 int WindowWidth;
@@ -27,6 +75,48 @@ static int collision = 1;
 static int dragging = 0;
 static int paused = 0;
 static int helpPanel = 1;
+static int profilerOverlay = 0;
+/* Set when anything on screen may have changed since the last presented frame.
+   While paused and clean the loop stops rendering and waits for events (see markSceneDirty) */
+static int sceneDirty = 1;
+static int waitingForEvents = 0;
+
+static struct AppOptions options;
+/* Frames, simulation steps and pair interactions computed so far, to normalise the hardware counters */
+static Uint64 renderedFrames = 0;
+static Uint64 simulationSteps = 0;
+static Uint64 pairInteractions = 0;
+/* Where T and the exit write the trace when --trace was not given */
+#define DEFAULT_TRACE_PATH "trace.json"
+
+/* Background checkpoints, the step the run resumed from and the step the next checkpoint is due at */
+static struct Checkpointer Checkpointer;
+static int checkpointing = 0;
+static Uint64 restoredSteps = 0;
+static Uint64 nextCheckpointStep = 0;
+/* Frames read back for --capture and written by its own threads */
+static struct FrameCapture FrameCapture;
+static int capturing = 0;
+/* Bodies written for --trajectory, for the replay tool, the simulated time they are stamped with,
+   and the frames simulated so far, counted from the first one, which is always recorded */
+static struct TrajectoryWriter TrajectoryWriter;
+static int recordingTrajectory = 0;
+static double simulationTime = 0.0;
+static Uint64 simulatedFrames = 0;
+
+/* Where --restart looks when --checkpoint was not given */
+#define DEFAULT_CHECKPOINT_BASE "checkpoint"
+
+/* Camera flown by --benchmark, the frame times it measured, and the camera recorded for --record-camera */
+static struct CameraPath BenchmarkPath;
+static struct FrameTimes BenchmarkTimes;
+static struct CameraPath RecordedCamera;
+static int recordingCamera = 0;
+static int benchmarkFrame = 0;
+/* Simulated time per benchmark frame, whatever the frame took, so every run simulates the same scene */
+#define BENCHMARK_DT (1.0f / 60.0f)
+/* Allocations of every frame so far, reported with the benchmark results */
+static Uint64 allocationsSoFar = 0;
 
 float CameraX = 0;
 float CameraY = 0;
@@ -43,36 +133,74 @@ const float zoomStep = 0.1f;
 float maximumZoom = 10.0f;
 float minimumZoom = 0.05f;
 
-/* This function calculates the distance between 2 points using Pythagorean theorem*/
-float distance(float x1, float y1, float x2, float y2)
+/* Asks for a new frame, and returns the main loop to its normal rate if it was waiting for events */
+static void markSceneDirty(void)
 {
-    return sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    sceneDirty = 1;
+    if (waitingForEvents)
+    {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, NULL);
+        waitingForEvents = 0;
+    }
 }
 
-/* This function draws a circle*/
-void DrawCircle(const float size, float x, float y)
+/* This function adds a body at rest at a world position. Returns -1 when out of memory.*/
+static int spawnObject(float x, float y, float size)
 {
+    struct Object circle;
 
-    int detail = (int)(4 + SDL_logf(size + 1.0f) * 15.0f);
-    if (detail > 360)
-        detail = 360;
+    circle.dx = 0.0f;
+    circle.dy = 0.0f;
+    circle.size = size;
+    circle.x = x;
+    circle.y = y;
+    // Calculate the mass according to the size
+    circle.mass = circle.size * circle.size * PI * BODY_DENSITY;
 
-    float step = 2.0f * PI / detail;
+    if (initCirBuffer(&circle.trailBuffer, NUMBER_OF_TRAIL_PARTICLES) != 0)
+    {
+        return -1;
+    }
+    resetTrailSampler(&circle.trailSampler);
 
-    int i = 0;
-    struct SDL_FPoint *cirPoints = SDL_malloc(detail * sizeof(struct SDL_FPoint));
+    if (AddObject(&ObjectContainer, circle) < 0)
+    {
+        SDL_free(circle.trailBuffer.buffer);
+        return -1;
+    }
+    objectIndexDirty = 1;
+    return 0;
+}
+
+/* This function places a fixed, seeded cloud of bodies around the camera so every benchmark run draws the same scene*/
+static int spawnBenchmarkBodies(int Count)
+{
+    const float radius = 2000.0f;
 
-    for (float angle = 0; angle < 2.0f * PI; angle += step)
+    SDL_srand(1);
+    for (int i = 0; i < Count; ++i)
     {
-        float px = x + SDL_cosf(angle) * size;
-        float py = y + SDL_sinf(angle) * size;
-        cirPoints[i] = (struct SDL_FPoint){px, py};
-        ++i;
-        if (i >= detail)
-            break;
+        /* Uniform over the disc*/
+        float r = radius * SDL_sqrtf(SDL_randf());
+        float angle = SDL_randf() * 2.0f * PI;
+        float size = (SDL_randf() + 1.0f) * 15.0f;
+        if (spawnObject(CameraX + r * SDL_cosf(angle), CameraY + r * SDL_sinf(angle), size) != 0)
+        {
+            return -1;
+        }
     }
-    SDL_RenderPoints(renderer, cirPoints, detail);
-    SDL_free(cirPoints);
+    return 0;
+}
+
+/* This function switches every quality knob to a step of the governor ladder*/
+static void applyQualitySettings(const struct QualitySettings *Settings)
+{
+    Scene.TrailLength = SDL_min(Settings->TrailLength, NUMBER_OF_TRAIL_PARTICLES);
+    SetCircleDetailBias(Settings->CircleDetailBias);
+    Scene.PointRadius = Settings->PointRadius;
+    Scene.SpriteRadius = Settings->SpriteRadius;
+    Scene.TrailSpacing = Settings->TrailSpacing;
+    physicsSubsteps = Settings->PhysicsSubsteps;
 }
 
 /* This function runs once at startup. */
@@ -80,6 +208,24 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 {
     SDL_SetAppMetadata("Simulation", "1.0", "com.hung.simulation");
 
+    if (ParseOptions(argc, argv, &options) != 0)
+    {
+        return SDL_APP_FAILURE;
+    }
+    if (options.AllocationStats && !InstallAllocationHooks())
+    {
+        SDL_Log("Couldn't install allocation hooks: %s", SDL_GetError());
+    }
+    if (options.PerfCounters && !OpenPerfCounters())
+    {
+        SDL_Log("Couldn't open hardware counters: %s", SDL_GetError());
+    }
+    SetTraceThreadName("main");
+    if (options.TracePath != NULL)
+    {
+        StartTraceRecorder();
+    }
+
     SDL_Color color = {255, 255, 255, SDL_ALPHA_OPAQUE};
 
     if (!SDL_Init(SDL_INIT_VIDEO))
@@ -94,7 +240,15 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_SetRenderVSync(renderer, SDL_RENDERER_VSYNC_ADAPTIVE))
+    if (options.BenchmarkFrames > 0)
+    {
+        /* Measure the renderer, not the display refresh rate*/
+        if (!SDL_SetRenderVSync(renderer, 0))
+        {
+            SDL_Log("Couldn't disable VSync, frame times are capped by the display: %s", SDL_GetError());
+        }
+    }
+    else if (!SDL_SetRenderVSync(renderer, SDL_RENDERER_VSYNC_ADAPTIVE))
     {
         SDL_Log("Adaptive VSync not supported, trying normal VSync");
         if (!SDL_SetRenderVSync(renderer, 1))
@@ -142,7 +296,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    struct TextLabel guides[7] = {
+    struct TextLabel guides[11] = {
         (struct TextLabel){
             .text = "M - Spawn object at cursor",
             .dst = (SDL_FRect){100, 100, 250, 25}},
@@ -164,6 +318,18 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         (struct TextLabel){
             .text = "Scroll to zoom",
             .dst = (SDL_FRect){100, 250, 150, 25}},
+        (struct TextLabel){
+            .text = "R - Switch body render mode",
+            .dst = (SDL_FRect){100, 275, 275, 25}},
+        (struct TextLabel){
+            .text = "C - Toggle merging of distant clusters",
+            .dst = (SDL_FRect){100, 300, 375, 25}},
+        (struct TextLabel){
+            .text = "F - Toggle frame profiler",
+            .dst = (SDL_FRect){100, 325, 250, 25}},
+        (struct TextLabel){
+            .text = "T - Start/write a trace recording",
+            .dst = (SDL_FRect){100, 350, 325, 25}},
 
         };
 
@@ -192,6 +358,133 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         }
     }
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    InitCircleTables();
+
+    if (options.CapturePath != NULL)
+    {
+        if (StartFrameCapture(&FrameCapture, options.CapturePath, options.CaptureWriters) != 0)
+        {
+            SDL_Log("Couldn't start frame capture: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        capturing = 1;
+    }
+
+    if (options.TrajectoryPath != NULL)
+    {
+        if (OpenTrajectoryWriter(&TrajectoryWriter, options.TrajectoryPath) != 0)
+        {
+            SDL_Log("Couldn't start trajectory: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        recordingTrajectory = 1;
+    }
+    recordingCamera = options.RecordCameraFile != NULL;
+
+    /* The atlas is created below, until then automatic mode draws circles*/
+    InitSceneRenderer(&Scene, &DiscAtlas);
+    SceneScale.Scale = options.RenderScale;
+    SceneScale.TargetMs = options.DynamicRenderScale ? options.FrameTargetMs : 0.0f;
+    if (options.QualityGovernor)
+    {
+        InitQualityGovernor(&QualityGovernor, options.FrameTargetMs);
+        applyQualitySettings(QualityLevelSettings(QualityGovernor.Level));
+    }
+
+    if (CreateDiscAtlas(renderer, &DiscAtlas) != 0)
+    {
+        SDL_Log("Couldn't create disc sprites, sprite render mode is unavailable: %s", SDL_GetError());
+    }
+
+    if (InitFrameArena(&FrameArena, FRAME_ARENA_SIZE) != 0)
+    {
+        SDL_Log("Cannot allocate frame arena.");
+        return SDL_APP_FAILURE;
+    }
+
+    if (CreateThreadPool(&WorkerPool, 0) != 0)
+    {
+        SDL_Log("Couldn't create worker threads.");
+        return SDL_APP_FAILURE;
+    }
+
+    if (options.CheckpointBase != NULL || options.Restart)
+    {
+        if (InitCheckpointer(&Checkpointer, options.CheckpointBase != NULL ? options.CheckpointBase : DEFAULT_CHECKPOINT_BASE) != 0)
+        {
+            SDL_Log("Couldn't start checkpoint writer: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        checkpointing = options.CheckpointBase != NULL;
+    }
+
+    /* A restart replaces the scene the other options would build*/
+    int restored = 0;
+    if (options.Restart)
+    {
+        if (RestoreNewestCheckpoint(&Checkpointer, &ObjectContainer, &WorkerPool, &restoredSteps, &simulationTime) == 0)
+        {
+            SDL_Log("Resumed from step %" SDL_PRIu64 " at %.2f s of simulated time", restoredSteps, simulationTime);
+            restored = 1;
+        }
+        else
+        {
+            SDL_Log("Couldn't restart, starting a new scene: %s", SDL_GetError());
+        }
+    }
+    nextCheckpointStep = restoredSteps + options.CheckpointEvery;
+
+    if (!restored && options.ScenarioFile != NULL && LoadScenario(&ObjectContainer, &WorkerPool, options.ScenarioFile) != 0)
+    {
+        SDL_Log("Couldn't load scenario: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    if (!restored && options.GeneratorName != NULL)
+    {
+        int generator = FindScenarioGenerator(options.GeneratorName);
+        if (generator < 0)
+        {
+            SDL_Log("Unknown generator %s, expected disk, plummer, kepler or merger", options.GeneratorName);
+            return SDL_APP_FAILURE;
+        }
+        /* Centred on the middle of the window*/
+        Uint64 generateStart = SDL_GetPerformanceCounter();
+        if (GenerateScenario(&ObjectContainer, &WorkerPool, generator, options.GeneratorBodies, options.GeneratorSeed, CameraX, CameraY) != 0)
+        {
+            SDL_Log("Cannot allocate generated bodies.");
+            return SDL_APP_FAILURE;
+        }
+        SDL_Log("Generated %d bodies (%s, seed %" SDL_PRIu64 ") in %.2f s", options.GeneratorBodies, ScenarioGeneratorName(generator),
+                options.GeneratorSeed, (SDL_GetPerformanceCounter() - generateStart) / (double)SDL_GetPerformanceFrequency());
+    }
+
+    if (options.BenchmarkFrames > 0)
+    {
+        if (options.CameraPathFile != NULL)
+        {
+            if (LoadCameraPath(&BenchmarkPath, options.CameraPathFile) != 0)
+            {
+                SDL_Log("Couldn't load camera path: %s", SDL_GetError());
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (BuildDefaultCameraPath(&BenchmarkPath, CameraX, CameraY, zoom) != 0)
+        {
+            SDL_Log("Cannot allocate camera path.");
+            return SDL_APP_FAILURE;
+        }
+        if (InitFrameTimes(&BenchmarkTimes, options.BenchmarkFrames) != 0)
+        {
+            SDL_Log("Cannot allocate frame times.");
+            return SDL_APP_FAILURE;
+        }
+        if (ObjectContainer.NumItems == 0 && spawnBenchmarkBodies(options.BenchmarkBodies) != 0)
+        {
+            SDL_Log("Cannot allocate benchmark bodies.");
+            return SDL_APP_FAILURE;
+        }
+        SDL_Log("Benchmark: %d frames, %d bodies, %d camera keys", options.BenchmarkFrames, ObjectContainer.NumItems, BenchmarkPath.NumKeys);
+    }
     return SDL_APP_CONTINUE; /* carry on with the program! */
 }
 
@@ -203,33 +496,27 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
         return SDL_APP_SUCCESS; /* end the program, reporting success to the OS. */
     }
 
+    /* Moving the mouse without dragging the camera leaves the picture as it is */
+    if (event->type != SDL_EVENT_MOUSE_MOTION || dragging)
+    {
+        markSceneDirty();
+    }
+
     /*When M is pressed, add object to simulation*/
     if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_M)
     {
-        // Add an object to the simulation
-        struct Object circle;
-
-        circle.dx = 0.0f;
-        circle.dy = 0.0f;
-        // A random size 0.0f - 30.0f
-        circle.size = (SDL_randf() + 1.0f) * 15.0f;
+        // Add an object to the simulation, a random size 15.0f - 30.0f
+        float size = (SDL_randf() + 1.0f) * 15.0f;
 
         float MouseX;
         float MouseY;
         SDL_GetMouseState(&MouseX, &MouseY);
         // Calculate the positiom based on mouse pos and cameraRoot
-        circle.y = cameraRootY - MouseY / zoom;
-        circle.x = cameraRootX - MouseX / zoom;
-        // Calculate the mass according to the size
-        circle.mass = circle.size * circle.size * PI * 8;
-
-        circle.trailBuffer.capacity = NUMBER_OF_TRAIL_PARTICLES;
-        circle.trailBuffer.count = 0;
-        circle.trailBuffer.readPointer = 0;
-        circle.trailBuffer.writePointer = 0;
-        circle.trailBuffer.buffer = SDL_malloc(circle.trailBuffer.capacity * sizeof(struct SDL_FRect));
-
-        AddObject(&ObjectContainer, circle);
+        if (spawnObject(cameraRootX - MouseX / zoom, cameraRootY - MouseY / zoom, size) != 0)
+        {
+            SDL_Log("Cannot allocate trail buffer for new object.");
+            return SDL_APP_CONTINUE;
+        }
     }
     /* Otherwise, if N is pressed, toggle collision*/
     else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_N)
@@ -242,6 +529,7 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
     {
         // Delete all objects
         ClearObjects(&ObjectContainer);
+        objectIndexDirty = 1;
         // Reset capacity after successful malloc
         ObjectContainer.Capacity = NUMBER_OF_BALLS;
         ObjectContainer.Data = SDL_malloc(ObjectContainer.Capacity * sizeof(struct Object));
@@ -251,8 +539,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
             return SDL_APP_FAILURE;
         }
     }
-    /* Otherwise, if O is pressed, pause/continue the simulation*/
-    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_O)
+    /* Otherwise, if O is pressed, pause/continue the simulation (a benchmark always runs)*/
+    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_O && options.BenchmarkFrames == 0)
     {
         paused = !paused;
     }
@@ -261,6 +549,42 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
     {
         helpPanel = !helpPanel;
     }
+    /* Otherwise, if F is pressed, toggle the frame profiler overlay*/
+    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_F)
+    {
+        profilerOverlay = !profilerOverlay;
+    }
+    /* Otherwise, if T is pressed, start recording a trace, or write out and stop the running one*/
+    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_T)
+    {
+        if (!IsTraceRecording())
+        {
+            StartTraceRecorder();
+        }
+        else
+        {
+            const char *path = options.TracePath != NULL ? options.TracePath : DEFAULT_TRACE_PATH;
+            if (FlushTraceRecorder(path) != 0)
+            {
+                SDL_Log("Couldn't write trace to %s: %s", path, SDL_GetError());
+            }
+            StopTraceRecorder();
+        }
+    }
+    /* Otherwise, if C is pressed, toggle cluster aggregation*/
+    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_C)
+    {
+        aggregateClusters = !aggregateClusters;
+    }
+    /* Otherwise, if R is pressed, switch how bodies are drawn*/
+    else if (event->type == SDL_EVENT_KEY_DOWN && event->key.repeat == 0 && event->key.scancode == SDL_SCANCODE_R)
+    {
+        Scene.Mode = (Scene.Mode + 1) % BODY_RENDER_MODE_COUNT;
+        if (Scene.Mode == BODY_RENDER_SPRITE && DiscAtlas.Texture == NULL)
+        {
+            Scene.Mode = (Scene.Mode + 1) % BODY_RENDER_MODE_COUNT;
+        }
+    }
 
     /* If mouse button is down, start dragging*/
     if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN)
@@ -326,144 +650,54 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
     return SDL_APP_CONTINUE; /* carry on with the program! */
 }
 
-void calcPhysicsBetween2Objects(struct Object *selfObject, struct Object *otherObject, float dt)
+/* This function draws the members of a visible quadtree leaf*/
+static void renderLeaf(void *UserData, const int *Indices, int Count)
 {
-    float distanceBetweenObject = distance(otherObject->x, otherObject->y, selfObject->x, selfObject->y);
-
-    if (distanceBetweenObject <= selfObject->size + otherObject->size) // Collision, neuron activation, DOPAMINE RELEASED
+    for (int i = 0; i < Count; ++i)
     {
-        if (!collision)
-        {
-            return;
-        }
-
-        float m1 = selfObject->mass;
-        float m2 = otherObject->mass;
-
-        // 1D elastic collision formula for dx (repeat for dy)
-        float newDx1 = (selfObject->dx * (m1 - m2) + 2 * m2 * otherObject->dx) / (m1 + m2);
-        float newDx2 = (otherObject->dx * (m2 - m1) + 2 * m1 * selfObject->dx) / (m1 + m2);
-
-        float newDy1 = (selfObject->dy * (m1 - m2) + 2 * m2 * otherObject->dy) / (m1 + m2);
-        float newDy2 = (otherObject->dy * (m2 - m1) + 2 * m1 * selfObject->dy) / (m1 + m2);
-
-        selfObject->dx = newDx1;
-        selfObject->dy = newDy1;
-        otherObject->dx = newDx2;
-        otherObject->dy = newDy2;
-        return;
+        AddBodyToScene(UserData, &ObjectContainer.Data[Indices[i]]);
     }
-
-    /* Newton's Law of Universal Gravitation*/
-    float force = 1000.0f * ((selfObject->mass * otherObject->mass) / (distanceBetweenObject * distanceBetweenObject) + 50.0f);
-
-    /* Normalizing DirectionX and DirectionY*/
-    float invDist = 1.0f / distanceBetweenObject;
-    float directionX = (otherObject->x - selfObject->x) * invDist;
-    float directionY = (otherObject->y - selfObject->y) * invDist;
-
-    /* Finding acceleration with a formula derived from Newton's second law */
-    float selfAccel = force / selfObject->mass;
-    selfObject->dx += directionX * selfAccel * dt;
-    selfObject->dy += directionY * selfAccel * dt;
-
-    float otherAccel = force / otherObject->mass;
-    otherObject->dx -= directionX * otherAccel * dt;
-    otherObject->dy -= directionY * otherAccel * dt;
 }
 
-void renderTrailForObject(struct Object *selfObject)
+/* This function draws a whole quadtree node as one glyph*/
+static void renderAggregate(void *UserData, const struct QuadtreeNode *Node)
 {
-    int start = (selfObject->trailBuffer.writePointer - selfObject->trailBuffer.count + selfObject->trailBuffer.capacity) % selfObject->trailBuffer.capacity;
-    selfObject->trailBuffer.readPointer = start;
-
-    Uint8 PrevAlpha = 0;
-
-    Uint8 r, g, b, a;
-    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+    AddAggregateToScene(UserData, Node->ComX, Node->ComY, Node->Mass);
+}
 
-    for (int i = 0; i < selfObject->trailBuffer.count; ++i)
+void renderText(float dt)
+{
+    for (int i = 0; i < TextContainer.NumItems; ++i)
     {
-        struct SDL_FRect *trail = readCirBuffer(&selfObject->trailBuffer);
-
-        /* Calculate relative coordinates*/
-        float TrailRelativeX = cameraRootX - trail->x;
-        float TrailRelativeY = cameraRootY - trail->y;
-
-        /* Apply zoom*/
-        TrailRelativeX *= zoom;
-        TrailRelativeY *= zoom;
-        float TrailSizeX = trail->w * (zoom + 0.5f);
-        float TrailSizeY = trail->h * (zoom + 0.5f);
-
-        if (!(
-                TrailRelativeX + TrailSizeX < 0 || TrailRelativeX - TrailSizeX > WindowWidth ||
-                TrailRelativeY + TrailSizeY < 0 || TrailRelativeY - TrailSizeY > WindowHeight))
+        if (helpPanel)
         {
-            SDL_FRect screenRect = {
-                .x = TrailRelativeX,
-                .y = TrailRelativeY,
-                .w = TrailSizeX,
-                .h = TrailSizeY}; // Create a copy
-
-            int steps = (selfObject->trailBuffer.readPointer - selfObject->trailBuffer.writePointer + selfObject->trailBuffer.capacity) % selfObject->trailBuffer.capacity;
-            Uint8 alphaval;
-
-            if (steps == 0)
-            {
-                alphaval = 0; // Fully transparent if there are no steps.
-            }
-            else if (steps == selfObject->trailBuffer.capacity - 1)
-            {
-                alphaval = 255; // Fully opaque when we are one step from being full.
-            }
-            else
-            {
-                alphaval = (Uint8)(255.0f * ((float)steps / (float)selfObject->trailBuffer.capacity));
-            }
-
-            if (alphaval != PrevAlpha)
-            {
-                SDL_SetRenderDrawColor(renderer, r, g, b, alphaval);
-                PrevAlpha = alphaval;
-            }
-
-            SDL_RenderFillRect(renderer, &screenRect);
+            SDL_RenderTexture(renderer, TextContainer.Data[i].Texture, NULL, &TextContainer.Data[i].dst);
         }
     }
-    SDL_SetRenderDrawColor(renderer, r, g, b, a);
 }
 
-void renderObject(struct Object *selfObject)
+/* This function closes the allocation counts of a frame and, with --alloc-check, reports a warmed-up frame that still allocates*/
+static void checkFrameAllocations(void)
 {
-    /* Calculate relative coordinates*/
-    float ObjectRelativeX = cameraRootX - selfObject->x;
-    float ObjectRelativeY = cameraRootY - selfObject->y;
+    static Uint64 frameNumber = 0;
+    EndAllocationFrame();
+    ++frameNumber;
 
-    /* Apply zoom*/
-    ObjectRelativeX *= zoom;
-    ObjectRelativeY *= zoom;
-    float ObjectSize = selfObject->size * zoom;
-
-    /* Check if object is out-of-bound, if yes then don't render*/
-    if (!(
-            ObjectRelativeX + ObjectSize < 0 || ObjectRelativeX - ObjectSize > WindowWidth ||
-            ObjectRelativeY + ObjectSize < 0 || ObjectRelativeY - ObjectSize > WindowHeight))
+    const struct AllocationStats *stats = LastFrameAllocations();
+    allocationsSoFar += TotalAllocations(stats);
+    if (options.AllocationCheckAfter <= 0 || frameNumber <= (Uint64)options.AllocationCheckAfter || TotalAllocations(stats) == 0)
     {
-        /* Render the object*/
-        DrawCircle(ObjectSize, ObjectRelativeX, ObjectRelativeY);
+        return;
     }
-}
 
-void renderText(float dt)
-{
-    for (int i = 0; i < TextContainer.NumItems; ++i)
+    for (int tag = 0; tag < ALLOCATION_TAGS; ++tag)
     {
-        if (helpPanel)
+        if (stats->Allocations[tag] > 0)
         {
-            SDL_RenderTexture(renderer, TextContainer.Data[i].Texture, NULL, &TextContainer.Data[i].dst);
+            SDL_Log("Frame %" SDL_PRIu64 ": %d allocations (%" SDL_PRIu64 " bytes) in %s", frameNumber, stats->Allocations[tag], stats->Bytes[tag], AllocationTagName(tag));
         }
     }
+    SDL_assert(!"steady state frame allocated memory");
 }
 
 /* This function runs once per frame, and is the heart of the program. */
@@ -473,9 +707,58 @@ SDL_AppResult SDL_AppIterate(void *appstate)
     Uint64 freq = SDL_GetPerformanceFrequency();
 
     float dt = (now - lastTime) / (float)freq;
+    float intervalMs = dt * 1000.0f;
     lastTime = now;
     if (dt > 0.05f)
         dt = 0.05f; // cap at 50ms (20 FPS)
+    if (options.BenchmarkFrames > 0)
+    {
+        dt = BENCHMARK_DT;
+    }
+
+    /* Nothing moves while paused, so after one clean frame wait for input instead of redrawing the same picture */
+    if (paused && !sceneDirty && options.BenchmarkFrames == 0)
+    {
+        if (!waitingForEvents)
+        {
+            SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "waitevent");
+            waitingForEvents = 1;
+        }
+        return SDL_APP_CONTINUE;
+    }
+    sceneDirty = !paused;
+
+    if (options.BenchmarkFrames > 0)
+    {
+        /* The path replaces any camera input, so every run draws the same frames*/
+        float position = options.BenchmarkFrames > 1 ? benchmarkFrame / (float)(options.BenchmarkFrames - 1) : 0.0f;
+        struct CameraKey key = SampleCameraPath(&BenchmarkPath, position);
+        CameraX = key.CameraX;
+        CameraY = key.CameraY;
+        zoom = SDL_clamp(key.Zoom, minimumZoom, maximumZoom);
+        cameraRootX = CameraX + (WindowWidth * 0.5f) / zoom;
+        cameraRootY = CameraY + (WindowHeight * 0.5f) / zoom;
+    }
+    if (recordingCamera && AddCameraKey(&RecordedCamera, (struct CameraKey){CameraX, CameraY, zoom}) != 0)
+    {
+        SDL_Log("Cannot allocate camera key, camera recording stopped after %d keys.", RecordedCamera.NumKeys);
+        recordingCamera = 0;
+    }
+
+    BeginProfileFrame();
+
+    /* Everything transient from the previous frame is released at once*/
+    ResetFrameArena(&FrameArena);
+    ResetPoolArenas(&WorkerPool);
+    BindSceneRenderer(&Scene, &FrameArena);
+
+    /* Below native resolution the scene is drawn into a smaller target, stretched over the window before the text*/
+    if (BeginScaledScene(renderer, &SceneScale, WindowWidth, WindowHeight) != 0)
+    {
+        SDL_Log("Couldn't create scaled scene target, drawing at native resolution: %s", SDL_GetError());
+        SceneScale.Scale = RENDER_SCALE_MAX;
+        SceneScale.TargetMs = 0.0f;
+    }
 
     /* as you can see from this, rendering draws over whatever was drawn before it. */
     SDL_SetRenderDrawColor(renderer, 1, 1, 1, SDL_ALPHA_OPAQUE); /* grey, full alpha (full opacity) */
@@ -483,48 +766,197 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE); /* while, full alpha */
 
-    // Render and handle Objects
-    for (int i = 0; i < ObjectContainer.NumItems; ++i)
+    // Handle Objects
+    if (!paused)
     {
-        struct Object *selfObject = &ObjectContainer.Data[i];
-
-        if (!paused)
+        /* Substeps split the frame time evenly, trails are sampled once the frame is done*/
+        float stepDt = dt / physicsSubsteps;
+        for (int step = 0; step < physicsSubsteps; ++step)
         {
-            for (int j = i + 1; j < ObjectContainer.NumItems; ++j)
+            BeginProfileStage(PROFILE_FORCES);
+            for (int i = 0; i < ObjectContainer.NumItems; ++i)
             {
-                struct Object *otherObject = &ObjectContainer.Data[j];
-                calcPhysicsBetween2Objects(selfObject, otherObject, dt);
+                struct Object *selfObject = &ObjectContainer.Data[i];
+                for (int j = i + 1; j < ObjectContainer.NumItems; ++j)
+                {
+                    struct Object *otherObject = &ObjectContainer.Data[j];
+                    calcPhysicsBetween2Objects(selfObject, otherObject, stepDt, collision);
+                }
             }
+            EndProfileStage(PROFILE_FORCES);
+            ++simulationSteps;
+            pairInteractions += (Uint64)ObjectContainer.NumItems * (ObjectContainer.NumItems - 1) / 2;
 
-            float prevX = selfObject->x;
-            float prevY = selfObject->y;
+            BeginProfileStage(PROFILE_INTEGRATION);
+            for (int i = 0; i < ObjectContainer.NumItems; ++i)
+            {
+                struct Object *selfObject = &ObjectContainer.Data[i];
 
-            selfObject->x += selfObject->dx * dt; // Apply dx
-            selfObject->y += selfObject->dy * dt; // Apply dy
+                selfObject->x += selfObject->dx * stepDt; // Apply dx
+                selfObject->y += selfObject->dy * stepDt; // Apply dy
+            }
+            EndProfileStage(PROFILE_INTEGRATION);
+        }
 
-            float steps = distance(selfObject->x, selfObject->y, prevX, prevY);
-            float jumps = 2.0f / (steps / 2.0f);
+        /* Append trails, the sampler decides whether a position is worth a sample*/
+        BeginProfileStage(PROFILE_TRAIL_WRITES);
+        for (int i = 0; i < ObjectContainer.NumItems; ++i)
+        {
+            struct Object *selfObject = &ObjectContainer.Data[i];
+            sampleTrail(&selfObject->trailSampler, &selfObject->trailBuffer, selfObject->x, selfObject->y);
+        }
+        EndProfileStage(PROFILE_TRAIL_WRITES);
+        objectIndexDirty = 1;
+
+        simulationTime += dt;
+        Uint64 simulatedFrame = simulatedFrames++;
+        if (recordingTrajectory && simulatedFrame % options.TrajectoryEvery == 0 &&
+            WriteTrajectoryFrame(&TrajectoryWriter, &ObjectContainer, simulationTime) != 0)
+        {
+            SDL_Log("Couldn't write trajectory, recording stopped: %s", SDL_GetError());
+            CloseTrajectoryWriter(&TrajectoryWriter);
+            recordingTrajectory = 0;
+        }
 
-            for (float t = 0; t < 1; t += jumps)
+        /* Bodies are only copied here, the file is written in the background*/
+        if (checkpointing && restoredSteps + simulationSteps >= nextCheckpointStep)
+        {
+            int result = WriteCheckpoint(&Checkpointer, &ObjectContainer, restoredSteps + simulationSteps, simulationTime);
+            if (result < 0)
+            {
+                SDL_Log("Couldn't start checkpoint: %s", SDL_GetError());
+            }
+            /* A checkpoint still being written delays the next one to a later frame*/
+            if (result <= 0)
             {
-                float lerpX = prevX + (selfObject->x - prevX) * t;
-                float lerpY = prevY + (selfObject->y - prevY) * t;
-                /* Append trail*/
-                writeCirBuffer(&selfObject->trailBuffer, (SDL_FRect){lerpX - 1.0f, lerpY - 1.0f, 2.0f, 2.0f});
+                nextCheckpointStep = restoredSteps + simulationSteps + options.CheckpointEvery;
             }
         }
+    }
 
-        /* Render trail*/
-        renderTrailForObject(selfObject);
+    /* Only visit objects whose disc or trail overlaps the camera rectangle*/
+    BeginProfileStage(PROFILE_SPATIAL_INDEX);
+    if (objectIndexDirty)
+    {
+        if (BuildSpatialGrid(&ObjectGrid, &ObjectContainer) != 0 || BuildQuadtree(&ObjectTree, &ObjectContainer) != 0)
+        {
+            SDL_Log("Cannot allocate spatial index.");
+            return SDL_APP_FAILURE;
+        }
+        objectIndexDirty = 0;
+    }
+    /* An object is reported once at most, so the list never outgrows the object count*/
+    VisibleObjects.Capacity = SDL_max(ObjectContainer.NumItems, 1);
+    VisibleObjects.Data = ArenaAlloc(&FrameArena, VisibleObjects.Capacity * sizeof(int));
+    if (VisibleObjects.Data == NULL)
+    {
+        SDL_Log("Cannot allocate visible object list.");
+        return SDL_APP_FAILURE;
+    }
+    /* Trails are drawn wider than their samples, widen the rectangle accordingly*/
+    float margin = TRAIL_PARTICLE_SIZE * (zoom + 0.5f) / zoom;
+    if (QuerySpatialGrid(&ObjectGrid,
+                         cameraRootX - WindowWidth / zoom - margin, cameraRootY - WindowHeight / zoom - margin,
+                         cameraRootX + margin, cameraRootY + margin, &VisibleObjects) != 0)
+    {
+        SDL_Log("Visible object list overflowed.");
+        return SDL_APP_FAILURE;
+    }
+    EndProfileStage(PROFILE_SPATIAL_INDEX);
 
-        /* Render object*/
-        renderObject(selfObject);
+    Scene.View = (struct View){cameraRootX, cameraRootY, zoom, WindowWidth, WindowHeight};
+    if (Scene.Mode == BODY_RENDER_DENSITY)
+    {
+        BeginProfileStage(PROFILE_BODY_RENDER);
+        /* Trails are not drawn in this mode, they would cost per body again*/
+        if (RenderDensityMap(renderer, &WorkerPool, &DensityMap, &ObjectContainer, VisibleObjects.Data, VisibleObjects.NumItems, &Scene.View) != 0)
+        {
+            SDL_Log("Couldn't render density map, switching back to geometry: %s", SDL_GetError());
+            Scene.Mode = BODY_RENDER_GEOMETRY;
+        }
+        EndProfileStage(PROFILE_BODY_RENDER);
+    }
+    else
+    {
+        /* Render trails, all of them in one draw call*/
+        BeginProfileStage(PROFILE_TRAIL_RENDER);
+        for (int i = 0; i < VisibleObjects.NumItems; ++i)
+        {
+            AddTrailToScene(&Scene, &ObjectContainer.Data[VisibleObjects.Data[i]]);
+        }
+        FlushSceneTrails(renderer, &Scene);
+        EndProfileStage(PROFILE_TRAIL_RENDER);
+
+        /* Render objects, one draw call per level of detail*/
+        BeginProfileStage(PROFILE_BODY_RENDER);
+        if (Scene.Mode == BODY_RENDER_AUTO && aggregateClusters)
+        {
+            WalkQuadtree(&ObjectTree, &Scene.View, aggregatePixels, renderLeaf, renderAggregate, &Scene);
+        }
+        else
+        {
+            for (int i = 0; i < VisibleObjects.NumItems; ++i)
+            {
+                AddBodyToScene(&Scene, &ObjectContainer.Data[VisibleObjects.Data[i]]);
+            }
+        }
+        FlushSceneBodies(renderer, &Scene);
+        EndProfileStage(PROFILE_BODY_RENDER);
     }
 
     // Render text
+    BeginProfileStage(PROFILE_TEXT);
+    EndScaledScene(renderer, &SceneScale);
     renderText(dt);
+    if (profilerOverlay)
+    {
+        RenderProfilerOverlay(renderer, 20.0f, WindowHeight - 420.0f);
+    }
+    EndProfileStage(PROFILE_TEXT);
 
+    float busyMs = (SDL_GetPerformanceCounter() - now) * 1000.0f / freq;
+    BeginProfileStage(PROFILE_PRESENT);
+    if (capturing)
+    {
+        CaptureFrame(&FrameCapture, renderer);
+    }
     SDL_RenderPresent(renderer); /* put it all on the screen! */
+    EndProfileStage(PROFILE_PRESENT);
+
+    if (checkpointing)
+    {
+        PollCheckpointer(&Checkpointer);
+    }
+
+    if (UpdateRenderScale(&SceneScale, intervalMs, busyMs))
+    {
+        SDL_Log("Render scale %.2f", SceneScale.Scale);
+    }
+    if (options.QualityGovernor && UpdateQualityGovernor(&QualityGovernor, intervalMs, busyMs))
+    {
+        const struct QualitySettings *settings = QualityLevelSettings(QualityGovernor.Level);
+        applyQualitySettings(settings);
+        SDL_Log("Quality level %d (%.1f ms per frame): %d trail samples, circle detail -%d, points below %.1f px, sprites below %.1f px, trail spacing %.1f px, %d physics substeps",
+                QualityGovernor.Level, QualityGovernor.Times.IntervalMs, settings->TrailLength, settings->CircleDetailBias,
+                settings->PointRadius, settings->SpriteRadius, settings->TrailSpacing, settings->PhysicsSubsteps);
+    }
+
+    EndProfileFrame();
+    ++renderedFrames;
+
+    if (AllocationHooksInstalled())
+    {
+        checkFrameAllocations();
+    }
+
+    if (options.BenchmarkFrames > 0)
+    {
+        AddFrameTime(&BenchmarkTimes, (SDL_GetPerformanceCounter() - now) * 1000.0f / freq);
+        if (++benchmarkFrame == options.BenchmarkFrames)
+        {
+            return SDL_APP_SUCCESS;
+        }
+    }
 
     return SDL_APP_CONTINUE; /* carry on with the program! */
 }
@@ -533,6 +965,52 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 void SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
     /* SDL will clean up the window/renderer for us. */
+    if (IsTraceRecording())
+    {
+        const char *path = options.TracePath != NULL ? options.TracePath : DEFAULT_TRACE_PATH;
+        if (FlushTraceRecorder(path) != 0)
+        {
+            SDL_Log("Couldn't write trace to %s: %s", path, SDL_GetError());
+        }
+        StopTraceRecorder();
+    }
+
+    if (options.BenchmarkFrames > 0)
+    {
+        LogFrameTimes(&BenchmarkTimes);
+        if (AllocationHooksInstalled())
+        {
+            SDL_Log("Allocations: %" SDL_PRIu64 " over %" SDL_PRIu64 " frames", allocationsSoFar, renderedFrames);
+        }
+    }
+    if (options.RecordCameraFile != NULL && SaveCameraPath(&RecordedCamera, options.RecordCameraFile) != 0)
+    {
+        SDL_Log("Couldn't write camera path to %s: %s", options.RecordCameraFile, SDL_GetError());
+    }
+
+    if (capturing)
+    {
+        StopFrameCapture(&FrameCapture);
+    }
+
+    if (recordingTrajectory)
+    {
+        SDL_Log("Recorded %d trajectory frames, %d of them keyframes", TrajectoryWriter.NumFrames, TrajectoryWriter.NumKeyframes);
+        if (CloseTrajectoryWriter(&TrajectoryWriter) != 0)
+        {
+            SDL_Log("Couldn't finish trajectory: %s", SDL_GetError());
+        }
+    }
+
+    /* A checkpoint in flight is finished rather than left truncated*/
+    DestroyCheckpointer(&Checkpointer);
+
+    if (PerfCountersOpen())
+    {
+        LogPerfCounters(simulationSteps, simulatedFrames, renderedFrames, pairInteractions);
+        ClosePerfCounters();
+    }
+
     /* Clean up heap space:D*/
     if (ObjectContainer.Data != NULL)
     {
@@ -542,4 +1020,15 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
     {
         ClearTextLabels(&TextContainer);
     }
+    ClearSceneRenderer(&Scene);
+    DestroyDiscAtlas(&DiscAtlas);
+    DestroyDensityMap(&DensityMap);
+    DestroyRenderScale(&SceneScale);
+    DestroyThreadPool(&WorkerPool);
+    ClearSpatialGrid(&ObjectGrid);
+    ClearQuadtree(&ObjectTree);
+    DestroyFrameArena(&FrameArena);
+    ClearCameraPath(&BenchmarkPath);
+    ClearCameraPath(&RecordedCamera);
+    ClearFrameTimes(&BenchmarkTimes);
 }
\ No newline at end of file
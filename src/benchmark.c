@@ -0,0 +1,215 @@
+#include "benchmark.h"
+
+#define DEFAULT_PATH_KEYS 600
+
+int AddCameraKey(struct CameraPath *Path, struct CameraKey Key)
+{
+    if (Path->NumKeys == Path->Capacity)
+    {
+        int capacity = Path->Capacity > 0 ? Path->Capacity * 2 : 256;
+        struct CameraKey *keys = SDL_realloc(Path->Keys, capacity * sizeof(struct CameraKey));
+        if (keys == NULL)
+        {
+            return -1;
+        }
+        Path->Keys = keys;
+        Path->Capacity = capacity;
+    }
+    Path->Keys[Path->NumKeys++] = Key;
+    return 0;
+}
+
+int BuildDefaultCameraPath(struct CameraPath *Path, float StartX, float StartY, float StartZoom)
+{
+    const float turns = 2.0f;
+    const float radius = 400.0f;
+    const float farZoom = 0.1f;
+
+    for (int i = 0; i < DEFAULT_PATH_KEYS; ++i)
+    {
+        float t = i / (float)(DEFAULT_PATH_KEYS - 1);
+        /* 0 at both ends and 1 half way, so the flight starts and ends where the camera was*/
+        float out = 0.5f - 0.5f * SDL_cosf(t * 2.0f * SDL_PI_F);
+        float angle = t * turns * 2.0f * SDL_PI_F;
+
+        struct CameraKey key;
+        key.CameraX = StartX + SDL_sinf(angle) * radius * out;
+        key.CameraY = StartY + (1.0f - SDL_cosf(angle)) * radius * out;
+        /* Geometric blend, equal time at every scale*/
+        key.Zoom = StartZoom * SDL_powf(farZoom / StartZoom, out);
+
+        if (AddCameraKey(Path, key) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int LoadCameraPath(struct CameraPath *Path, const char *File)
+{
+    size_t size;
+    char *text = SDL_LoadFile(File, &size);
+    if (text == NULL)
+    {
+        return -1;
+    }
+
+    char *cursor = text;
+    char *end;
+    for (;;)
+    {
+        struct CameraKey key;
+        key.CameraX = (float)SDL_strtod(cursor, &end);
+        if (end == cursor)
+        {
+            break;
+        }
+        cursor = end;
+        key.CameraY = (float)SDL_strtod(cursor, &end);
+        if (end == cursor)
+        {
+            break;
+        }
+        cursor = end;
+        key.Zoom = (float)SDL_strtod(cursor, &end);
+        if (end == cursor || key.Zoom <= 0.0f)
+        {
+            break;
+        }
+        cursor = end;
+
+        if (AddCameraKey(Path, key) != 0)
+        {
+            SDL_free(text);
+            return -1;
+        }
+    }
+
+    /* Anything left but white space is a malformed line*/
+    while (*cursor != '\0' && SDL_isspace(*cursor))
+    {
+        ++cursor;
+    }
+    int valid = *cursor == '\0' && Path->NumKeys > 0;
+    SDL_free(text);
+    if (!valid)
+    {
+        SDL_SetError("%s is not a camera path", File);
+        return -1;
+    }
+    return 0;
+}
+
+int SaveCameraPath(const struct CameraPath *Path, const char *File)
+{
+    SDL_IOStream *stream = SDL_IOFromFile(File, "w");
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < Path->NumKeys; ++i)
+    {
+        const struct CameraKey *key = &Path->Keys[i];
+        if (SDL_IOprintf(stream, "%g %g %g\n", key->CameraX, key->CameraY, key->Zoom) == 0)
+        {
+            SDL_CloseIO(stream);
+            return -1;
+        }
+    }
+    return SDL_CloseIO(stream) ? 0 : -1;
+}
+
+struct CameraKey SampleCameraPath(const struct CameraPath *Path, float Position)
+{
+    if (Path->NumKeys == 1)
+    {
+        return Path->Keys[0];
+    }
+
+    float scaled = SDL_clamp(Position, 0.0f, 1.0f) * (Path->NumKeys - 1);
+    int first = SDL_min((int)scaled, Path->NumKeys - 2);
+    float t = scaled - first;
+
+    const struct CameraKey *a = &Path->Keys[first];
+    const struct CameraKey *b = &Path->Keys[first + 1];
+    struct CameraKey key;
+    key.CameraX = a->CameraX + (b->CameraX - a->CameraX) * t;
+    key.CameraY = a->CameraY + (b->CameraY - a->CameraY) * t;
+    key.Zoom = a->Zoom + (b->Zoom - a->Zoom) * t;
+    return key;
+}
+
+void ClearCameraPath(struct CameraPath *Path)
+{
+    SDL_free(Path->Keys);
+    SDL_zerop(Path);
+}
+
+int InitFrameTimes(struct FrameTimes *Times, int Frames)
+{
+    Times->NumFrames = 0;
+    Times->Capacity = Frames;
+    Times->Milliseconds = SDL_malloc(Frames * sizeof(float));
+    return Times->Milliseconds != NULL ? 0 : -1;
+}
+
+void AddFrameTime(struct FrameTimes *Times, float Milliseconds)
+{
+    if (Times->NumFrames < Times->Capacity)
+    {
+        Times->Milliseconds[Times->NumFrames++] = Milliseconds;
+    }
+}
+
+static int compareMilliseconds(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest rank, the same rule as the profiler overlay*/
+static float percentile(const float *Sorted, int Count, float Percentile)
+{
+    int rank = SDL_clamp((int)(Percentile / 100.0f * (Count - 1) + 0.5f), 0, Count - 1);
+    return Sorted[rank];
+}
+
+void LogFrameTimes(const struct FrameTimes *Times)
+{
+    int count = Times->NumFrames;
+    if (count == 0)
+    {
+        SDL_Log("Benchmark: no frames measured");
+        return;
+    }
+
+    float *sorted = SDL_malloc(count * sizeof(float));
+    if (sorted == NULL)
+    {
+        SDL_Log("Benchmark: out of memory for the report");
+        return;
+    }
+    SDL_memcpy(sorted, Times->Milliseconds, count * sizeof(float));
+    SDL_qsort(sorted, count, sizeof(float), compareMilliseconds);
+
+    double total = 0.0;
+    for (int i = 0; i < count; ++i)
+    {
+        total += sorted[i];
+    }
+    float mean = (float)(total / count);
+
+    SDL_Log("Benchmark: %d frames in %.1f ms, %.1f frames per second", count, total, mean > 0.0f ? 1000.0f / mean : 0.0f);
+    SDL_Log("Frame time (ms): mean %.3f  min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f",
+            mean, sorted[0], percentile(sorted, count, 50.0f), percentile(sorted, count, 95.0f), percentile(sorted, count, 99.0f), sorted[count - 1]);
+    SDL_free(sorted);
+}
+
+void ClearFrameTimes(struct FrameTimes *Times)
+{
+    SDL_free(Times->Milliseconds);
+    SDL_zerop(Times);
+}
@@ -0,0 +1,48 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <SDL3/SDL.h>
+
+/* One frame of a camera path: the camera offset and zoom as the main loop keeps them*/
+struct CameraKey
+{
+    float CameraX;
+    float CameraY;
+    float Zoom;
+};
+
+/* Camera positions of consecutive frames, recorded while flying around or loaded for a benchmark*/
+struct CameraPath
+{
+    int NumKeys;
+    int Capacity;
+    struct CameraKey *Keys;
+};
+
+/* Durations of the measured frames, in milliseconds*/
+struct FrameTimes
+{
+    int NumFrames;
+    int Capacity;
+    float *Milliseconds;
+};
+
+/* This function appends a key to the path. Returns -1 when out of memory.*/
+int AddCameraKey(struct CameraPath *Path, struct CameraKey Key);
+/* This function fills Path with the built-in flight: a zoom out to the whole scene and back while circling the start position.*/
+int BuildDefaultCameraPath(struct CameraPath *Path, float StartX, float StartY, float StartZoom);
+/* These functions read and write a path as one "x y zoom" line per key. They return -1 and set the SDL error on failure.*/
+int LoadCameraPath(struct CameraPath *Path, const char *File);
+int SaveCameraPath(const struct CameraPath *Path, const char *File);
+/* This function returns the camera at Position (0 - 1) along the path, interpolating between keys.*/
+struct CameraKey SampleCameraPath(const struct CameraPath *Path, float Position);
+void ClearCameraPath(struct CameraPath *Path);
+
+/* This function reserves room for Frames measurements up front, so measuring never allocates. Returns -1 when out of memory.*/
+int InitFrameTimes(struct FrameTimes *Times, int Frames);
+void AddFrameTime(struct FrameTimes *Times, float Milliseconds);
+/* This function logs the mean, min, max and the 50th, 95th and 99th percentiles of the measured frames.*/
+void LogFrameTimes(const struct FrameTimes *Times);
+void ClearFrameTimes(struct FrameTimes *Times);
+
+#endif
@@ -0,0 +1,297 @@
+#include "checkpoint.h"
+
+#include "scenario.h"
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ull
+#define CHECKSUM_PRIME 0x100000001b3ull
+
+/* Size of a checkpoint of Count bodies*/
+static size_t checkpointSize(int Count)
+{
+    return SCENARIO_HEADER_SIZE + (size_t)Count * SCENARIO_FIELDS * sizeof(float) + CHECKPOINT_FOOTER_SIZE;
+}
+
+/* FNV-1a over 32-bit words, mixed in while the words are stored so writing costs no second pass*/
+static Uint64 mixWord(Uint64 Hash, Uint32 Word)
+{
+    return (Hash ^ Word) * CHECKSUM_PRIME;
+}
+
+static Uint32 floatBits(float Value)
+{
+    Uint32 bits;
+    SDL_memcpy(&bits, &Value, sizeof(bits));
+    return bits;
+}
+
+static char *slotPath(const char *BasePath, int Slot)
+{
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s.%d.gmsb", BasePath, Slot) < 0)
+    {
+        return NULL;
+    }
+    return path;
+}
+
+int InitCheckpointer(struct Checkpointer *Checkpointer, const char *BasePath)
+{
+    SDL_zerop(Checkpointer);
+    Checkpointer->BasePath = BasePath;
+    Checkpointer->Queue = SDL_CreateAsyncIOQueue();
+    return Checkpointer->Queue != NULL ? 0 : -1;
+}
+
+int WriteCheckpoint(struct Checkpointer *Checkpointer, const struct ObjectList *Objects, Uint64 Step, double Time)
+{
+    if (Checkpointer->PendingTasks > 0)
+    {
+        return 1;
+    }
+
+    size_t size = checkpointSize(Objects->NumItems);
+    if (size > Checkpointer->StagingCapacity)
+    {
+        /* Leave room to grow, so spawning a few bodies does not reallocate at every checkpoint*/
+        size_t capacity = size + size / 2;
+        char *staging = SDL_realloc(Checkpointer->Staging, capacity);
+        if (staging == NULL)
+        {
+            return -1;
+        }
+        Checkpointer->Staging = staging;
+        Checkpointer->StagingCapacity = capacity;
+    }
+
+    /* Header, bodies and checksum, all little-endian words*/
+    Uint32 *words = (Uint32 *)Checkpointer->Staging;
+    Uint64 checksum = CHECKSUM_SEED;
+    SDL_memcpy(words, SCENARIO_MAGIC, 4);
+    words[1] = SDL_Swap32LE(SCENARIO_VERSION);
+    words[2] = SDL_Swap32LE((Uint32)Objects->NumItems);
+    words[3] = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        checksum = mixWord(checksum, words[i]);
+    }
+
+    Uint32 *record = words + SCENARIO_HEADER_SIZE / sizeof(Uint32);
+    for (int i = 0; i < Objects->NumItems; ++i, record += SCENARIO_FIELDS)
+    {
+        const struct Object *body = &Objects->Data[i];
+        record[0] = SDL_Swap32LE(floatBits(body->x));
+        record[1] = SDL_Swap32LE(floatBits(body->y));
+        record[2] = SDL_Swap32LE(floatBits(body->dx));
+        record[3] = SDL_Swap32LE(floatBits(body->dy));
+        record[4] = SDL_Swap32LE(floatBits(body->size));
+        record[5] = SDL_Swap32LE(floatBits(body->mass));
+        for (int field = 0; field < SCENARIO_FIELDS; ++field)
+        {
+            checksum = mixWord(checksum, record[field]);
+        }
+    }
+
+    char *footer = (char *)record;
+    Uint64 stepLE = SDL_Swap64LE(Step);
+    Uint64 timeBits;
+    SDL_memcpy(&timeBits, &Time, sizeof(timeBits));
+    Uint64 timeLE = SDL_Swap64LE(timeBits);
+    SDL_memcpy(footer, CHECKPOINT_FOOTER_MAGIC, 4);
+    SDL_memcpy(footer + 4, &stepLE, sizeof(stepLE));
+    SDL_memcpy(footer + 12, &timeLE, sizeof(timeLE));
+    for (int i = 0; i < 5; ++i)
+    {
+        checksum = mixWord(checksum, record[i]);
+    }
+    Uint64 checksumLE = SDL_Swap64LE(checksum);
+    SDL_memcpy(footer + 20, &checksumLE, sizeof(checksumLE));
+
+    /* The oldest file is overwritten, the others stay valid if this one never completes*/
+    char *path = slotPath(Checkpointer->BasePath, Checkpointer->NextSlot);
+    if (path == NULL)
+    {
+        return -1;
+    }
+    SDL_AsyncIO *file = SDL_AsyncIOFromFile(path, "w");
+    SDL_free(path);
+    if (file == NULL)
+    {
+        return -1;
+    }
+    /* The close is queued behind the write, and flushes so a completed checkpoint survives a power loss*/
+    if (!SDL_WriteAsyncIO(file, Checkpointer->Staging, 0, size, Checkpointer->Queue, Checkpointer))
+    {
+        /* Nothing of this checkpoint is in flight, its close outcome is ignored*/
+        SDL_CloseAsyncIO(file, false, Checkpointer->Queue, NULL);
+        return -1;
+    }
+    Checkpointer->PendingTasks = 1;
+    Checkpointer->WriteFailed = 0;
+    if (SDL_CloseAsyncIO(file, true, Checkpointer->Queue, Checkpointer))
+    {
+        ++Checkpointer->PendingTasks;
+    }
+    else
+    {
+        Checkpointer->WriteFailed = 1;
+    }
+
+    Checkpointer->WritingSlot = Checkpointer->NextSlot;
+    Checkpointer->WritingStep = Step;
+    Checkpointer->NextSlot = (Checkpointer->NextSlot + 1) % CHECKPOINT_SLOTS;
+    return 0;
+}
+
+/* This function handles one finished task, the checkpoint is done once all of its tasks are*/
+static void finishTask(struct Checkpointer *Checkpointer, const SDL_AsyncIOOutcome *Outcome)
+{
+    if (Outcome->userdata != Checkpointer || Checkpointer->PendingTasks == 0)
+    {
+        return;
+    }
+    if (Outcome->result != SDL_ASYNCIO_COMPLETE ||
+        (Outcome->type == SDL_ASYNCIO_TASK_WRITE && Outcome->bytes_transferred != Outcome->bytes_requested))
+    {
+        Checkpointer->WriteFailed = 1;
+    }
+    if (--Checkpointer->PendingTasks > 0)
+    {
+        return;
+    }
+
+    if (Checkpointer->WriteFailed)
+    {
+        SDL_Log("Couldn't write checkpoint of step %" SDL_PRIu64 " to %s.%d.gmsb: %s", Checkpointer->WritingStep, Checkpointer->BasePath, Checkpointer->WritingSlot, SDL_GetError());
+    }
+}
+
+void PollCheckpointer(struct Checkpointer *Checkpointer)
+{
+    SDL_AsyncIOOutcome outcome;
+    while (Checkpointer->Queue != NULL && SDL_GetAsyncIOResult(Checkpointer->Queue, &outcome))
+    {
+        finishTask(Checkpointer, &outcome);
+    }
+}
+
+/* This function checks the size, footer and checksum of a checkpoint in memory and reads its step and time. Returns false when it is not valid.*/
+static bool validateCheckpoint(const char *Data, size_t Size, Uint64 *Step, double *Time)
+{
+    if (Size < SCENARIO_HEADER_SIZE + CHECKPOINT_FOOTER_SIZE || SDL_memcmp(Data, SCENARIO_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+    Uint64 count;
+    SDL_memcpy(&count, Data + 8, sizeof(count));
+    count = SDL_Swap64LE(count);
+    if (count > (Uint64)SDL_MAX_SINT32 || Size != checkpointSize((int)count))
+    {
+        return false;
+    }
+
+    const char *footer = Data + Size - CHECKPOINT_FOOTER_SIZE;
+    const char *checksummed = footer + 20;
+    Uint64 checksum = CHECKSUM_SEED;
+    for (const char *p = Data; p < checksummed; p += sizeof(Uint32))
+    {
+        Uint32 word;
+        SDL_memcpy(&word, p, sizeof(word));
+        checksum = mixWord(checksum, word);
+    }
+    Uint64 storedStep;
+    Uint64 storedTime;
+    Uint64 storedChecksum;
+    SDL_memcpy(&storedStep, footer + 4, sizeof(storedStep));
+    SDL_memcpy(&storedTime, footer + 12, sizeof(storedTime));
+    SDL_memcpy(&storedChecksum, footer + 20, sizeof(storedChecksum));
+    if (SDL_memcmp(footer, CHECKPOINT_FOOTER_MAGIC, 4) != 0 || SDL_Swap64LE(storedChecksum) != checksum)
+    {
+        return false;
+    }
+
+    *Step = SDL_Swap64LE(storedStep);
+    storedTime = SDL_Swap64LE(storedTime);
+    SDL_memcpy(Time, &storedTime, sizeof(*Time));
+    return true;
+}
+
+int RestoreNewestCheckpoint(struct Checkpointer *Checkpointer, struct ObjectList *Objects, struct ThreadPool *Pool, Uint64 *Step, double *Time)
+{
+    /* Each file is read once, the newest valid one stays loaded to be parsed*/
+    int newest = -1;
+    char *newestPath = NULL;
+    char *newestData = NULL;
+    size_t newestSize = 0;
+    Uint64 newestStep = 0;
+    double newestTime = 0.0;
+    for (int slot = 0; slot < CHECKPOINT_SLOTS; ++slot)
+    {
+        char *path = slotPath(Checkpointer->BasePath, slot);
+        if (path == NULL)
+        {
+            SDL_free(newestPath);
+            SDL_free(newestData);
+            return -1;
+        }
+        size_t size;
+        char *data = SDL_LoadFile(path, &size);
+        Uint64 step;
+        double time;
+        bool valid = data != NULL && validateCheckpoint(data, size, &step, &time);
+        if (!valid && SDL_GetPathInfo(path, NULL))
+        {
+            SDL_Log("Skipping damaged checkpoint %s", path);
+        }
+
+        if (valid && (newest < 0 || step > newestStep))
+        {
+            SDL_free(newestPath);
+            SDL_free(newestData);
+            newest = slot;
+            newestPath = path;
+            newestData = data;
+            newestSize = size;
+            newestStep = step;
+            newestTime = time;
+        }
+        else
+        {
+            SDL_free(path);
+            SDL_free(data);
+        }
+    }
+    if (newest < 0)
+    {
+        SDL_SetError("no valid checkpoint at %s.0.gmsb to %s.%d.gmsb", Checkpointer->BasePath, Checkpointer->BasePath, CHECKPOINT_SLOTS - 1);
+        return -1;
+    }
+
+    /* The footer is past the bodies, so a checkpoint parses like any binary scenario*/
+    int result = ParseScenario(Objects, Pool, newestPath, newestData, newestSize);
+    SDL_free(newestPath);
+    SDL_free(newestData);
+    if (result != 0)
+    {
+        return -1;
+    }
+
+    *Step = newestStep;
+    *Time = newestTime;
+    Checkpointer->NextSlot = (newest + 1) % CHECKPOINT_SLOTS;
+    return 0;
+}
+
+void DestroyCheckpointer(struct Checkpointer *Checkpointer)
+{
+    SDL_AsyncIOOutcome outcome;
+    while (Checkpointer->PendingTasks > 0 && SDL_WaitAsyncIOResult(Checkpointer->Queue, &outcome, -1))
+    {
+        finishTask(Checkpointer, &outcome);
+    }
+    if (Checkpointer->Queue != NULL)
+    {
+        SDL_DestroyAsyncIOQueue(Checkpointer->Queue);
+    }
+    SDL_free(Checkpointer->Staging);
+    SDL_zerop(Checkpointer);
+}
@@ -0,0 +1,48 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+#include "threadPool.h"
+
+/* Checkpoints rotate over this many files, BasePath.0.gmsb, BasePath.1.gmsb and so on*/
+#define CHECKPOINT_SLOTS 3
+
+/* A checkpoint is a binary scenario file (see scenario.h) followed by this footer: the tag, a little-endian Uint64 simulation step,
+   the simulated time as the bits of a little-endian double, and a Uint64 checksum of everything before it. */
+#define CHECKPOINT_FOOTER_MAGIC "GMSC"
+#define CHECKPOINT_FOOTER_SIZE 28
+
+/* Writes checkpoints in the background through SDL_AsyncIO. The caller only pays for copying the bodies into the staging buffer,
+   which stays with the write until it has been flushed to disk and closed. */
+struct Checkpointer
+{
+    const char *BasePath;
+    SDL_AsyncIOQueue *Queue;
+
+    char *Staging;
+    size_t StagingCapacity;
+
+    /* Tasks of the checkpoint in flight (write and close), Staging belongs to it until none are left*/
+    int PendingTasks;
+    int WritingSlot;
+    Uint64 WritingStep;
+    int WriteFailed;
+
+    int NextSlot;
+};
+
+/* This function prepares checkpoints under BasePath. Returns -1 and sets the SDL error on failure.*/
+int InitCheckpointer(struct Checkpointer *Checkpointer, const char *BasePath);
+/* This function copies the bodies and starts writing them to the next file. Returns 1 when the previous checkpoint is still being written and nothing was started, -1 on failure.*/
+int WriteCheckpoint(struct Checkpointer *Checkpointer, const struct ObjectList *Objects, Uint64 Step, double Time);
+/* This function collects finished writes and reports failures. Call it once per frame.*/
+void PollCheckpointer(struct Checkpointer *Checkpointer);
+/* This function appends the bodies of the newest checkpoint that passes its checksum and sets Step and Time to its step and simulated time.
+   Writing then continues with the file after it. Returns -1 and sets the SDL error when no checkpoint is valid. */
+int RestoreNewestCheckpoint(struct Checkpointer *Checkpointer, struct ObjectList *Objects, struct ThreadPool *Pool, Uint64 *Step, double *Time);
+/* This function waits for a checkpoint in flight and frees everything.*/
+void DestroyCheckpointer(struct Checkpointer *Checkpointer);
+
+#endif
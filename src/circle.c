@@ -0,0 +1,85 @@
+#include "circle.h"
+
+#define PI 3.14159265f
+
+static const int levelSegments[CIRCLE_LOD_LEVELS] = {8, 16, 24, 32, 48, 64, 96, 128};
+
+/* Largest on-screen radius each level is used for*/
+static float levelMaxRadius[CIRCLE_LOD_LEVELS];
+
+/* Unit circle rims of every level, stored one after another*/
+static SDL_FPoint unitCircle[8 + 16 + 24 + 32 + 48 + 64 + 96 + 128];
+static int levelOffset[CIRCLE_LOD_LEVELS];
+
+/* Levels dropped from every circle, raised when frames run over budget*/
+static int detailBias = 0;
+
+void InitCircleTables(void)
+{
+    int offset = 0;
+    for (int level = 0; level < CIRCLE_LOD_LEVELS; ++level)
+    {
+        int segments = levelSegments[level];
+        float step = 2.0f * PI / segments;
+
+        levelOffset[level] = offset;
+        for (int i = 0; i < segments; ++i)
+        {
+            unitCircle[offset + i] = (SDL_FPoint){SDL_cosf(i * step), SDL_sinf(i * step)};
+        }
+        offset += segments;
+
+        /* Same detail curve as before: 4 + ln(radius + 1) * 15 rim points, inverted to a radius bound*/
+        levelMaxRadius[level] = SDL_expf((segments - 4) / 15.0f) - 1.0f;
+    }
+}
+
+int CircleDetailLevel(float radius)
+{
+    int level = 0;
+    while (level < CIRCLE_LOD_LEVELS - 1 && radius > levelMaxRadius[level])
+    {
+        ++level;
+    }
+    return SDL_max(level - detailBias, 0);
+}
+
+void SetCircleDetailBias(int Bias)
+{
+    detailBias = SDL_clamp(Bias, 0, CIRCLE_LOD_LEVELS - 1);
+}
+
+int CircleSegments(int level)
+{
+    return levelSegments[level];
+}
+
+int AddCircleToBatch(struct VertexBatch *WishedBatch, float x, float y, float radius, SDL_FColor color)
+{
+    int level = CircleDetailLevel(radius);
+    int segments = levelSegments[level];
+    const SDL_FPoint *rim = &unitCircle[levelOffset[level]];
+
+    int first = ReserveVertexBatch(WishedBatch, segments + 1, segments * 3);
+    if (first < 0)
+    {
+        return -1;
+    }
+
+    SDL_Vertex *vertices = &WishedBatch->Vertices[first];
+    vertices[0] = (SDL_Vertex){{x, y}, color, {0.0f, 0.0f}};
+    for (int i = 0; i < segments; ++i)
+    {
+        vertices[i + 1] = (SDL_Vertex){{x + rim[i].x * radius, y + rim[i].y * radius}, color, {0.0f, 0.0f}};
+    }
+
+    /* Triangle fan around the centre vertex*/
+    int *indices = &WishedBatch->Indices[WishedBatch->NumIndices - segments * 3];
+    for (int i = 0; i < segments; ++i)
+    {
+        indices[i * 3] = first;
+        indices[i * 3 + 1] = first + 1 + i;
+        indices[i * 3 + 2] = first + 1 + (i + 1) % segments;
+    }
+    return 0;
+}
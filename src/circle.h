@@ -0,0 +1,20 @@
+#ifndef CIRCLE_H
+#define CIRCLE_H
+
+#include "vertexBatch.h"
+
+/* Number of precomputed circle detail levels*/
+#define CIRCLE_LOD_LEVELS 8
+
+/* This function fills the unit-circle tables. It must run once before any circle is added.*/
+void InitCircleTables(void);
+/* This function returns the detail level used for a circle of the given on-screen radius*/
+int CircleDetailLevel(float radius);
+/* This function makes every circle Bias detail levels coarser than its radius asks for, 0 restores full detail*/
+void SetCircleDetailBias(int Bias);
+/* This function returns the number of rim vertices of a detail level*/
+int CircleSegments(int level);
+/* This function appends a filled circle as a triangle fan. Returns -1 if the allocation fails.*/
+int AddCircleToBatch(struct VertexBatch *WishedBatch, float x, float y, float radius, SDL_FColor color);
+
+#endif
@@ -1,19 +1,153 @@
 #include "circularBuffer.h"
 
-void writeCirBuffer(struct cirBuffer *wishedBuffer, struct SDL_FRect passedRect)
+#if TRAIL_COMPACT_SAMPLES
+/* This function checks whether a position can be encoded relative to the buffer's origin*/
+static int fitsSample(const struct cirBuffer *wishedBuffer, float x, float y)
 {
-    wishedBuffer->buffer[wishedBuffer->writePointer] = passedRect;
+    float qx = (x - wishedBuffer->originX) / TRAIL_SAMPLE_QUANTUM;
+    float qy = (y - wishedBuffer->originY) / TRAIL_SAMPLE_QUANTUM;
+    return qx > SDL_MIN_SINT16 && qx < SDL_MAX_SINT16 && qy > SDL_MIN_SINT16 && qy < SDL_MAX_SINT16;
+}
+
+static struct trailSample encodeSample(const struct cirBuffer *wishedBuffer, float x, float y)
+{
+    struct trailSample sample;
+    sample.x = (Sint16)SDL_lroundf((x - wishedBuffer->originX) / TRAIL_SAMPLE_QUANTUM);
+    sample.y = (Sint16)SDL_lroundf((y - wishedBuffer->originY) / TRAIL_SAMPLE_QUANTUM);
+    return sample;
+}
+
+static struct SDL_FPoint decodeSample(const struct cirBuffer *wishedBuffer, struct trailSample sample)
+{
+    return (struct SDL_FPoint){
+        wishedBuffer->originX + sample.x * TRAIL_SAMPLE_QUANTUM,
+        wishedBuffer->originY + sample.y * TRAIL_SAMPLE_QUANTUM};
+}
+
+/* This function moves the origin to a new point and re-encodes the stored samples against it.
+   Samples that no longer fit are the oldest ones, so the history is cut just after the newest of them. */
+static void rebaseCirBuffer(struct cirBuffer *wishedBuffer, float x, float y)
+{
+    int start = (wishedBuffer->writePointer - wishedBuffer->count + wishedBuffer->capacity) % wishedBuffer->capacity;
+    int kept = wishedBuffer->count;
+
+    struct cirBuffer previous = *wishedBuffer;
+    wishedBuffer->originX = x;
+    wishedBuffer->originY = y;
+
+    for (int i = 0; i < previous.count; ++i)
+    {
+        int index = (start + i) % previous.capacity;
+        struct SDL_FPoint point = decodeSample(&previous, previous.buffer[index]);
+
+        if (fitsSample(wishedBuffer, point.x, point.y))
+        {
+            wishedBuffer->buffer[index] = encodeSample(wishedBuffer, point.x, point.y);
+        }
+        else
+        {
+            kept = previous.count - i - 1;
+        }
+    }
+    wishedBuffer->count = kept;
+}
+#else
+static struct trailSample encodeSample(const struct cirBuffer *wishedBuffer, float x, float y)
+{
+    return (struct trailSample){x, y};
+}
+
+static struct SDL_FPoint decodeSample(const struct cirBuffer *wishedBuffer, struct trailSample sample)
+{
+    return (struct SDL_FPoint){sample.x, sample.y};
+}
+#endif
+
+/* This function recomputes the exact bounds of the stored samples*/
+static void refreshBounds(struct cirBuffer *wishedBuffer)
+{
+    int start = (wishedBuffer->writePointer - wishedBuffer->count + wishedBuffer->capacity) % wishedBuffer->capacity;
+    struct SDL_FPoint first = decodeSample(wishedBuffer, wishedBuffer->buffer[start]);
+    wishedBuffer->minX = wishedBuffer->maxX = first.x;
+    wishedBuffer->minY = wishedBuffer->maxY = first.y;
+
+    for (int i = 1; i < wishedBuffer->count; ++i)
+    {
+        struct SDL_FPoint point = decodeSample(wishedBuffer, wishedBuffer->buffer[(start + i) % wishedBuffer->capacity]);
+        wishedBuffer->minX = SDL_min(wishedBuffer->minX, point.x);
+        wishedBuffer->minY = SDL_min(wishedBuffer->minY, point.y);
+        wishedBuffer->maxX = SDL_max(wishedBuffer->maxX, point.x);
+        wishedBuffer->maxY = SDL_max(wishedBuffer->maxY, point.y);
+    }
+    wishedBuffer->writesSinceBounds = 0;
+}
+
+/* This function allocates storage for a buffer and resets it to empty. Returns -1 if the allocation fails.*/
+void initCirBufferWithStorage(struct cirBuffer *wishedBuffer, int capacity, struct trailSample *storage)
+{
+    wishedBuffer->capacity = capacity;
+    wishedBuffer->count = 0;
+    wishedBuffer->readPointer = 0;
+    wishedBuffer->writePointer = 0;
+    wishedBuffer->originX = 0.0f;
+    wishedBuffer->originY = 0.0f;
+    wishedBuffer->writesSinceBounds = 0;
+    wishedBuffer->sharedStorage = 1;
+    wishedBuffer->buffer = storage;
+}
+
+int initCirBuffer(struct cirBuffer *wishedBuffer, int capacity)
+{
+    initCirBufferWithStorage(wishedBuffer, capacity, SDL_malloc(capacity * sizeof(struct trailSample)));
+    wishedBuffer->sharedStorage = 0;
+
+    return wishedBuffer->buffer == NULL ? -1 : 0;
+}
+
+void writeCirBuffer(struct cirBuffer *wishedBuffer, float x, float y)
+{
+#if TRAIL_COMPACT_SAMPLES
+    if (wishedBuffer->count == 0)
+    {
+        wishedBuffer->originX = x;
+        wishedBuffer->originY = y;
+    }
+    else if (!fitsSample(wishedBuffer, x, y))
+    {
+        rebaseCirBuffer(wishedBuffer, x, y);
+    }
+#endif
+
+    wishedBuffer->buffer[wishedBuffer->writePointer] = encodeSample(wishedBuffer, x, y);
     wishedBuffer->writePointer = (wishedBuffer->writePointer + 1) % wishedBuffer->capacity;
 
     if (wishedBuffer->count < wishedBuffer->capacity)
     {
         ++wishedBuffer->count;
     }
+
+    /* Grow the bounds by the new sample, and shrink them back now and then once old samples get evicted*/
+    if (wishedBuffer->count == 1)
+    {
+        wishedBuffer->minX = wishedBuffer->maxX = x;
+        wishedBuffer->minY = wishedBuffer->maxY = y;
+    }
+    else if (wishedBuffer->count == wishedBuffer->capacity && ++wishedBuffer->writesSinceBounds >= TRAIL_BOUNDS_REFRESH)
+    {
+        refreshBounds(wishedBuffer);
+    }
+    else
+    {
+        wishedBuffer->minX = SDL_min(wishedBuffer->minX, x);
+        wishedBuffer->minY = SDL_min(wishedBuffer->minY, y);
+        wishedBuffer->maxX = SDL_max(wishedBuffer->maxX, x);
+        wishedBuffer->maxY = SDL_max(wishedBuffer->maxY, y);
+    }
 }
 
-struct SDL_FRect *readCirBuffer(struct cirBuffer *wishedBuffer)
+struct SDL_FPoint readCirBuffer(struct cirBuffer *wishedBuffer)
 {
-    struct SDL_FRect *value = &wishedBuffer->buffer[wishedBuffer->readPointer];
+    struct SDL_FPoint value = decodeSample(wishedBuffer, wishedBuffer->buffer[wishedBuffer->readPointer]);
     wishedBuffer->readPointer = (wishedBuffer->readPointer + 1) % wishedBuffer->capacity;
     return value;
 }
@@ -3,6 +3,28 @@
 
 #include <SDL3/SDL.h>
 
+/* When enabled, trail samples are stored as 16-bit offsets from a per-trail origin (4 bytes per sample).
+   Otherwise they are stored as plain float positions (8 bytes per sample). */
+#ifndef TRAIL_COMPACT_SAMPLES
+#define TRAIL_COMPACT_SAMPLES 1
+#endif
+
+/* World units per quantisation step of a compact sample, which gives a range of +-4096 units around the origin. */
+#define TRAIL_SAMPLE_QUANTUM 0.125f
+
+#if TRAIL_COMPACT_SAMPLES
+struct trailSample
+{
+    Sint16 x;
+    Sint16 y;
+};
+#else
+struct trailSample
+{
+    float x;
+    float y;
+};
+#endif
 
 /* Circular buffer*/
 struct cirBuffer
@@ -13,10 +35,30 @@ struct cirBuffer
     int count;
     int capacity;
 
-    struct SDL_FRect *buffer;
+    /* Every sample is stored relative to this point, rebased when a new sample falls out of range */
+    float originX;
+    float originY;
+
+    /* World bounds of the stored samples. Conservative: eviction only shrinks them on the next refresh */
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+    int writesSinceBounds;
+
+    /* Set when buffer is part of a bulk allocation owned by the object list, and must not be freed on its own */
+    int sharedStorage;
+
+    struct trailSample *buffer;
 };
 
-void writeCirBuffer(struct cirBuffer *wishedBuffer, struct SDL_FRect passedRect);
-struct SDL_FRect *readCirBuffer(struct cirBuffer *wishedBuffer);
+/* A full buffer recomputes its exact bounds once every this many writes*/
+#define TRAIL_BOUNDS_REFRESH 16
+
+int initCirBuffer(struct cirBuffer *wishedBuffer, int capacity);
+/* This function sets up a buffer over capacity samples of existing storage instead of allocating its own*/
+void initCirBufferWithStorage(struct cirBuffer *wishedBuffer, int capacity, struct trailSample *storage);
+void writeCirBuffer(struct cirBuffer *wishedBuffer, float x, float y);
+struct SDL_FPoint readCirBuffer(struct cirBuffer *wishedBuffer);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "densityMap.h"
+
+/* Rows of the density buffer handled by one merge or tone-mapping job*/
+#define DENSITY_BAND_ROWS 16
+
+struct splatJob
+{
+    struct DensityMap *Map;
+    const struct ObjectList *Objects;
+    const int *Indices;
+    int NumIndices;
+    const struct View *Camera;
+    int NumJobs;
+
+    /* Filled in by the tone-mapping pass*/
+    Uint8 *Pixels;
+    int Pitch;
+    float Scale;
+};
+
+/* This function (re)allocates the buffers and the texture when the view size changes*/
+static int resizeDensityMap(SDL_Renderer *Renderer, struct DensityMap *Map, int NumThreads, const struct View *Camera)
+{
+    int width = SDL_max(1, Camera->Width / DENSITY_DOWNSCALE);
+    int height = SDL_max(1, Camera->Height / DENSITY_DOWNSCALE);
+
+    if (Map->Texture != NULL && Map->Width == width && Map->Height == height && Map->NumPartials == NumThreads)
+    {
+        return 0;
+    }
+
+    DestroyDensityMap(Map);
+    Map->Width = width;
+    Map->Height = height;
+    Map->NumPartials = NumThreads;
+    Map->Partials = SDL_calloc((size_t)width * height * NumThreads, sizeof(float));
+    Map->BandMax = SDL_calloc((height + DENSITY_BAND_ROWS - 1) / DENSITY_BAND_ROWS, sizeof(float));
+    Map->Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+
+    if (Map->Partials == NULL || Map->BandMax == NULL || Map->Texture == NULL)
+    {
+        DestroyDensityMap(Map);
+        return -1;
+    }
+    SDL_SetTextureBlendMode(Map->Texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(Map->Texture, SDL_SCALEMODE_LINEAR);
+    return 0;
+}
+
+/* This function splats a contiguous range of the listed objects into the buffer of the running thread*/
+static void splatObjects(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct splatJob *job = UserData;
+    struct DensityMap *Map = job->Map;
+    const struct View *Camera = job->Camera;
+    float *partial = &Map->Partials[(size_t)ThreadIndex * Map->Width * Map->Height];
+
+    int first = (int)((Sint64)job->NumIndices * JobIndex / job->NumJobs);
+    int last = (int)((Sint64)job->NumIndices * (JobIndex + 1) / job->NumJobs);
+    float scale = Camera->Zoom / DENSITY_DOWNSCALE;
+
+    for (int i = first; i < last; ++i)
+    {
+        const struct Object *obj = &job->Objects->Data[job->Indices[i]];
+        int px = (int)SDL_floorf((Camera->RootX - obj->x) * scale);
+        int py = (int)SDL_floorf((Camera->RootY - obj->y) * scale);
+
+        if (px >= 0 && px < Map->Width && py >= 0 && py < Map->Height)
+        {
+            partial[py * Map->Width + px] += obj->mass;
+        }
+    }
+}
+
+/* This function sums the per-thread buffers of a band of rows into the first one and clears the others for the next frame*/
+static void mergeBand(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct splatJob *job = UserData;
+    struct DensityMap *Map = job->Map;
+    size_t planeSize = (size_t)Map->Width * Map->Height;
+
+    int firstRow = JobIndex * DENSITY_BAND_ROWS;
+    int lastRow = SDL_min(firstRow + DENSITY_BAND_ROWS, Map->Height);
+    float bandMax = 0.0f;
+
+    for (int row = firstRow; row < lastRow; ++row)
+    {
+        float *merged = &Map->Partials[(size_t)row * Map->Width];
+        for (int p = 1; p < Map->NumPartials; ++p)
+        {
+            float *partial = merged + p * planeSize;
+            for (int x = 0; x < Map->Width; ++x)
+            {
+                merged[x] += partial[x];
+                partial[x] = 0.0f;
+            }
+        }
+        for (int x = 0; x < Map->Width; ++x)
+        {
+            bandMax = SDL_max(bandMax, merged[x]);
+        }
+    }
+    Map->BandMax[JobIndex] = bandMax;
+}
+
+/* This function maps a band of merged densities to white pixels with a logarithmic alpha ramp*/
+static void toneMapBand(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct splatJob *job = UserData;
+    struct DensityMap *Map = job->Map;
+
+    int firstRow = JobIndex * DENSITY_BAND_ROWS;
+    int lastRow = SDL_min(firstRow + DENSITY_BAND_ROWS, Map->Height);
+
+    for (int row = firstRow; row < lastRow; ++row)
+    {
+        float *merged = &Map->Partials[(size_t)row * Map->Width];
+        Uint8 *texel = job->Pixels + (size_t)row * job->Pitch;
+
+        for (int x = 0; x < Map->Width; ++x, texel += 4)
+        {
+            float value = merged[x];
+            merged[x] = 0.0f;
+
+            Uint8 alpha = 0;
+            if (value > 0.0f)
+            {
+                alpha = (Uint8)SDL_min(255.0f, 48.0f + 207.0f * SDL_logf(1.0f + value) * job->Scale);
+            }
+            texel[0] = 255;
+            texel[1] = 255;
+            texel[2] = 255;
+            texel[3] = alpha;
+        }
+    }
+}
+
+int RenderDensityMap(SDL_Renderer *Renderer, struct ThreadPool *Pool, struct DensityMap *Map, const struct ObjectList *Objects, const int *Indices, int NumIndices, const struct View *Camera)
+{
+    if (resizeDensityMap(Renderer, Map, Pool->NumThreads, Camera) != 0)
+    {
+        return -1;
+    }
+
+    struct splatJob job = {.Map = Map, .Objects = Objects, .Indices = Indices, .NumIndices = NumIndices, .Camera = Camera};
+    int numBands = (Map->Height + DENSITY_BAND_ROWS - 1) / DENSITY_BAND_ROWS;
+
+    /* A few jobs per thread keeps the load balanced without much scheduling overhead*/
+    job.NumJobs = SDL_max(1, SDL_min(Pool->NumThreads * 4, NumIndices / 1024));
+    RunParallel(Pool, "density splat", splatObjects, &job, job.NumJobs);
+    RunParallel(Pool, "density merge", mergeBand, &job, numBands);
+
+    float maximum = 0.0f;
+    for (int i = 0; i < numBands; ++i)
+    {
+        maximum = SDL_max(maximum, Map->BandMax[i]);
+    }
+    job.Scale = maximum > 0.0f ? 1.0f / SDL_logf(1.0f + maximum) : 0.0f;
+
+    void *pixels;
+    if (!SDL_LockTexture(Map->Texture, NULL, &pixels, &job.Pitch))
+    {
+        SDL_memset(Map->Partials, 0, (size_t)Map->Width * Map->Height * sizeof(float));
+        return -1;
+    }
+    job.Pixels = pixels;
+    RunParallel(Pool, "density tone map", toneMapBand, &job, numBands);
+    SDL_UnlockTexture(Map->Texture);
+
+    SDL_FRect destination = {0.0f, 0.0f, (float)Map->Width * DENSITY_DOWNSCALE, (float)Map->Height * DENSITY_DOWNSCALE};
+    return SDL_RenderTexture(Renderer, Map->Texture, NULL, &destination) ? 0 : -1;
+}
+
+void DestroyDensityMap(struct DensityMap *Map)
+{
+    SDL_free(Map->Partials);
+    SDL_free(Map->BandMax);
+    Map->Partials = NULL;
+    Map->BandMax = NULL;
+    if (Map->Texture != NULL)
+    {
+        SDL_DestroyTexture(Map->Texture);
+        Map->Texture = NULL;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef DENSITYMAP_H
+#define DENSITYMAP_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+#include "threadPool.h"
+#include "view.h"
+
+/* Screen pixels per density cell along each axis*/
+#define DENSITY_DOWNSCALE 2
+
+/* Render mode for very large or far away scenes: bodies are splatted into a CPU density buffer,
+   tone-mapped and uploaded as one streaming texture, so the draw cost follows the pixel count. */
+struct DensityMap
+{
+    int Width;
+    int Height;
+
+    /* One accumulation buffer per pool thread, merged into the first one*/
+    int NumPartials;
+    float *Partials;
+    /* Largest merged value of each merge band, used to normalise the tone mapping*/
+    float *BandMax;
+
+    SDL_Texture *Texture;
+};
+
+/* This function draws the listed objects as a density image covering the whole view. Returns -1 on failure.*/
+int RenderDensityMap(SDL_Renderer *Renderer, struct ThreadPool *Pool, struct DensityMap *Map, const struct ObjectList *Objects, const int *Indices, int NumIndices, const struct View *Camera);
+void DestroyDensityMap(struct DensityMap *Map);
+
+#endif
@@ -0,0 +1,95 @@
+#include "discSprite.h"
+
+#define DISC_ATLAS_LARGEST 256
+
+int CreateDiscAtlas(SDL_Renderer *Renderer, struct DiscAtlas *Atlas)
+{
+    /* Every level is half the size of the previous one, so the atlas is a single row*/
+    int width = 0;
+    for (int level = 0; level < DISC_SPRITE_LEVELS; ++level)
+    {
+        width += DISC_ATLAS_LARGEST >> level;
+    }
+    int height = DISC_ATLAS_LARGEST;
+
+    Uint32 *pixels = SDL_calloc(width * height, sizeof(Uint32));
+    if (pixels == NULL)
+    {
+        return -1;
+    }
+
+    int cellX = 0;
+    for (int level = 0; level < DISC_SPRITE_LEVELS; ++level)
+    {
+        int cellSize = DISC_ATLAS_LARGEST >> level;
+        float centre = cellSize * 0.5f;
+        /* Keep a one pixel transparent border so linear filtering never bleeds into the neighbour*/
+        float radius = centre - 1.0f;
+
+        for (int py = 0; py < cellSize; ++py)
+        {
+            for (int px = 0; px < cellSize; ++px)
+            {
+                float dx = px + 0.5f - centre;
+                float dy = py + 0.5f - centre;
+                /* Coverage of the pixel, approximated by the distance of its centre to the edge*/
+                float coverage = SDL_clamp(radius - SDL_sqrtf(dx * dx + dy * dy) + 0.5f, 0.0f, 1.0f);
+                Uint8 alpha = (Uint8)(coverage * 255.0f + 0.5f);
+
+                Uint8 *texel = (Uint8 *)&pixels[py * width + cellX + px];
+                texel[0] = 255;
+                texel[1] = 255;
+                texel[2] = 255;
+                texel[3] = alpha;
+            }
+        }
+
+        Atlas->Cell[level] = (SDL_FRect){(float)cellX / width, 0.0f, (float)cellSize / width, (float)cellSize / height};
+        Atlas->Radius[level] = radius;
+        Atlas->QuadScale[level] = centre / radius;
+        cellX += cellSize;
+    }
+
+    Atlas->Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (Atlas->Texture == NULL)
+    {
+        SDL_free(pixels);
+        return -1;
+    }
+
+    SDL_UpdateTexture(Atlas->Texture, NULL, pixels, width * sizeof(Uint32));
+    SDL_SetTextureBlendMode(Atlas->Texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(Atlas->Texture, SDL_SCALEMODE_LINEAR);
+    SDL_free(pixels);
+    return 0;
+}
+
+void DestroyDiscAtlas(struct DiscAtlas *Atlas)
+{
+    if (Atlas->Texture != NULL)
+    {
+        SDL_DestroyTexture(Atlas->Texture);
+        Atlas->Texture = NULL;
+    }
+}
+
+int AddDiscSpriteToBatch(struct VertexBatch *WishedBatch, const struct DiscAtlas *Atlas, float x, float y, float radius, SDL_FColor color)
+{
+    /* Smallest disc that is still at least as large as the body on screen, so it is only ever minified*/
+    int level = DISC_SPRITE_LEVELS - 1;
+    while (level > 0 && Atlas->Radius[level] < radius)
+    {
+        --level;
+    }
+
+    const SDL_FRect *cell = &Atlas->Cell[level];
+    float half = radius * Atlas->QuadScale[level];
+
+    SDL_Vertex corners[4] = {
+        {{x - half, y - half}, color, {cell->x, cell->y}},
+        {{x + half, y - half}, color, {cell->x + cell->w, cell->y}},
+        {{x + half, y + half}, color, {cell->x + cell->w, cell->y + cell->h}},
+        {{x - half, y + half}, color, {cell->x, cell->y + cell->h}}};
+
+    return AddQuadToBatch(WishedBatch, corners);
+}
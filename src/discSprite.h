@@ -0,0 +1,29 @@
+#ifndef DISCSPRITE_H
+#define DISCSPRITE_H
+
+#include "vertexBatch.h"
+
+/* Number of pre-rendered disc sizes, from 256 px down to 8 px*/
+#define DISC_SPRITE_LEVELS 6
+
+/* A texture holding anti-aliased white discs of several sizes side by side, like a mip chain.
+   Bodies drawn from it are one textured quad each, whatever their radius. */
+struct DiscAtlas
+{
+    SDL_Texture *Texture;
+
+    /* Normalised texture rectangle of each level's cell*/
+    SDL_FRect Cell[DISC_SPRITE_LEVELS];
+    /* Disc radius in pixels of each level*/
+    float Radius[DISC_SPRITE_LEVELS];
+    /* Half the cell size divided by the disc radius, to size a quad so the disc edge lands on the body's radius*/
+    float QuadScale[DISC_SPRITE_LEVELS];
+};
+
+/* This function rasterises the discs and uploads them. Returns -1 on failure.*/
+int CreateDiscAtlas(SDL_Renderer *Renderer, struct DiscAtlas *Atlas);
+void DestroyDiscAtlas(struct DiscAtlas *Atlas);
+/* This function appends a body as a single textured quad. The batch must be flushed with the atlas texture.*/
+int AddDiscSpriteToBatch(struct VertexBatch *WishedBatch, const struct DiscAtlas *Atlas, float x, float y, float radius, SDL_FColor color);
+
+#endif
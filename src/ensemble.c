@@ -0,0 +1,461 @@
+/* Runs many small independent simulations without a window, for parameter sweeps, and writes one summary row per member.
+   A scene of a few hundred bodies cannot keep more than one core busy, so members are spread over the thread pool instead.
+   With --lanes, members of similar size are also interleaved ENSEMBLE_LANES at a time, so every pair of bodies
+   is one loop over lanes that the compiler turns into SIMD instructions. */
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+
+#include "objects.h"
+#include "generators.h"
+#include "physics.h"
+#include "ensembleKernel.h"
+#include "threadPool.h"
+
+#define DEFAULT_MEMBERS 64
+#define DEFAULT_MIN_BODIES 10
+#define DEFAULT_MAX_BODIES 200
+#define DEFAULT_STEPS 1000
+#define DEFAULT_DT (1.0f / 60.0f)
+
+struct EnsembleOptions
+{
+    const char *SummaryPath;
+    enum ScenarioGenerator Generator;
+    int NumMembers;
+    /* Every member gets its own body count in [MinBodies, MaxBodies], drawn from its seed*/
+    int MinBodies;
+    int MaxBodies;
+    /* Member i starts from seed Seed + i*/
+    Uint64 Seed;
+    int Steps;
+    float Dt;
+    int Collision;
+    int Lanes;
+    int Threads;
+};
+
+/* One simulation of the ensemble and, once it has run, its summary row*/
+struct ensembleMember
+{
+    Uint64 Seed;
+    int NumBodies;
+    int Done;
+
+    double InitialEnergy;
+    double FinalEnergy;
+    double MomentumX;
+    double MomentumY;
+    double CenterX;
+    double CenterY;
+    /* Root mean square distance of the bodies from their centre of mass*/
+    double Radius;
+};
+
+struct ensembleJob
+{
+    const struct EnsembleOptions *Options;
+    struct ensembleMember *Members;
+    /* Members in the order they are run, largest first so the pool finishes evenly*/
+    int *Order;
+    /* Interleaved kernel picked for the CPU, used with --lanes*/
+    EnsembleKernel Kernel;
+    SDL_AtomicInt Failed;
+};
+
+static void logUsage(const char *Program)
+{
+    SDL_Log("Usage: %s [options] SUMMARY\n"
+            "  Runs independent simulations side by side and writes one CSV row per member to SUMMARY.\n"
+            "  --members N           simulations in the ensemble (default 64)\n"
+            "  --bodies N or MIN-MAX bodies per member, drawn per member from its seed (default 10-200)\n"
+            "  --generator NAME      initial conditions: disk, plummer, kepler or merger (default disk)\n"
+            "  --seed N              seed of the first member, the others follow on (default 1)\n"
+            "  --steps N             physics steps per member (default 1000)\n"
+            "  --dt X                simulated seconds per step (default 1/60)\n"
+            "  --no-collision        bodies pass through each other\n"
+            "  --lanes               advance 8 members at once with the interleaved kernel\n"
+            "  --threads N           worker threads (default one per logical core)",
+            Program);
+}
+
+static int parseEnsembleOptions(int argc, char *argv[], struct EnsembleOptions *Options)
+{
+    SDL_zerop(Options);
+    Options->Generator = GENERATOR_DISK;
+    Options->NumMembers = DEFAULT_MEMBERS;
+    Options->MinBodies = DEFAULT_MIN_BODIES;
+    Options->MaxBodies = DEFAULT_MAX_BODIES;
+    Options->Seed = 1;
+    Options->Steps = DEFAULT_STEPS;
+    Options->Dt = DEFAULT_DT;
+    Options->Collision = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        /* Value of options that take one*/
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int count = 0;
+
+        if (SDL_strcmp(argv[i], "--members") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->NumMembers = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--bodies") == 0 && value != NULL &&
+                 (count = SDL_sscanf(value, "%d-%d", &Options->MinBodies, &Options->MaxBodies)) > 0 && Options->MinBodies > 0)
+        {
+            if (count == 1 || Options->MaxBodies < Options->MinBodies)
+            {
+                Options->MaxBodies = Options->MinBodies;
+            }
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--generator") == 0 && value != NULL && FindScenarioGenerator(value) >= 0)
+        {
+            Options->Generator = FindScenarioGenerator(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--seed") == 0 && value != NULL)
+        {
+            Options->Seed = SDL_strtoull(value, NULL, 10);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--steps") == 0 && value != NULL && SDL_atoi(value) >= 0)
+        {
+            Options->Steps = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--dt") == 0 && value != NULL && SDL_atof(value) > 0.0)
+        {
+            Options->Dt = (float)SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--no-collision") == 0)
+        {
+            Options->Collision = 0;
+        }
+        else if (SDL_strcmp(argv[i], "--lanes") == 0)
+        {
+            Options->Lanes = 1;
+        }
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->Threads = SDL_atoi(value);
+            ++i;
+        }
+        else if (argv[i][0] != '-' && Options->SummaryPath == NULL)
+        {
+            Options->SummaryPath = argv[i];
+        }
+        else
+        {
+            SDL_Log("Unknown or incomplete option: %s", argv[i]);
+            logUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (Options->SummaryPath == NULL)
+    {
+        logUsage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+/* This function returns the kinetic energy plus the potential of the pull between every pair, GRAVITY * (-m1 * m2 / r + PAIR_ATTRACTION * r)*/
+static double totalEnergy(const struct ObjectList *Bodies)
+{
+    double energy = 0.0;
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        const struct Object *self = &Bodies->Data[i];
+        energy += 0.5 * self->mass * ((double)self->dx * self->dx + (double)self->dy * self->dy);
+        for (int j = i + 1; j < Bodies->NumItems; ++j)
+        {
+            const struct Object *other = &Bodies->Data[j];
+            double r = distance(self->x, self->y, other->x, other->y);
+            if (r > 0.0)
+            {
+                energy += GRAVITY * (-(double)self->mass * other->mass / r + PAIR_ATTRACTION * r);
+            }
+        }
+    }
+    return energy;
+}
+
+/* This function fills in the summary row of a member from its bodies after the last step*/
+static void summarizeMember(struct ensembleMember *Member, const struct ObjectList *Bodies)
+{
+    double mass = 0.0;
+    Member->MomentumX = 0.0;
+    Member->MomentumY = 0.0;
+    Member->CenterX = 0.0;
+    Member->CenterY = 0.0;
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        const struct Object *body = &Bodies->Data[i];
+        mass += body->mass;
+        Member->MomentumX += (double)body->mass * body->dx;
+        Member->MomentumY += (double)body->mass * body->dy;
+        Member->CenterX += (double)body->mass * body->x;
+        Member->CenterY += (double)body->mass * body->y;
+    }
+    Member->CenterX /= mass;
+    Member->CenterY /= mass;
+
+    double spread = 0.0;
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        double x = Bodies->Data[i].x - Member->CenterX;
+        double y = Bodies->Data[i].y - Member->CenterY;
+        spread += x * x + y * y;
+    }
+    Member->Radius = SDL_sqrt(spread / Bodies->NumItems);
+    Member->FinalEnergy = totalEnergy(Bodies);
+    Member->Done = 1;
+}
+
+/* This function sets up the bodies of a member from its generator and seed. Returns -1 when out of memory.*/
+static int generateMember(const struct EnsembleOptions *Options, struct ensembleMember *Member, struct ObjectList *Bodies)
+{
+    SDL_zerop(Bodies);
+    if (GenerateScenario(Bodies, NULL, Options->Generator, Member->NumBodies, Member->Seed, 0.0f, 0.0f) != 0)
+    {
+        ClearObjects(Bodies);
+        return -1;
+    }
+    Member->InitialEnergy = totalEnergy(Bodies);
+    return 0;
+}
+
+/* This function advances one member by one step, the same way the simulation does*/
+static void stepMember(struct ObjectList *Bodies, float Dt, int Collision)
+{
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        struct Object *selfObject = &Bodies->Data[i];
+        for (int j = i + 1; j < Bodies->NumItems; ++j)
+        {
+            calcPhysicsBetween2Objects(selfObject, &Bodies->Data[j], Dt, Collision);
+        }
+    }
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        Bodies->Data[i].x += Bodies->Data[i].dx * Dt;
+        Bodies->Data[i].y += Bodies->Data[i].dy * Dt;
+    }
+}
+
+static void runMember(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct ensembleJob *job = UserData;
+    const struct EnsembleOptions *options = job->Options;
+    struct ensembleMember *member = &job->Members[job->Order[JobIndex]];
+
+    struct ObjectList bodies;
+    if (generateMember(options, member, &bodies) != 0)
+    {
+        SDL_AddAtomicInt(&job->Failed, 1);
+        return;
+    }
+    for (int step = 0; step < options->Steps; ++step)
+    {
+        stepMember(&bodies, options->Dt, options->Collision);
+    }
+    summarizeMember(member, &bodies);
+    ClearObjects(&bodies);
+}
+
+static void runPack(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct ensembleJob *job = UserData;
+    const struct EnsembleOptions *options = job->Options;
+    int first = JobIndex * ENSEMBLE_LANES;
+    int lanes = SDL_min(ENSEMBLE_LANES, options->NumMembers - first);
+
+    struct ObjectList bodies[ENSEMBLE_LANES];
+    struct EnsemblePack pack;
+    SDL_zero(bodies);
+    SDL_zero(pack);
+
+    /* Members are sorted largest first, so the first one sets the size of the pack*/
+    pack.NumBodies = job->Members[job->Order[first]].NumBodies;
+    size_t fieldSize = (size_t)pack.NumBodies * ENSEMBLE_LANES * sizeof(float);
+    pack.Storage = SDL_aligned_alloc(LANE_ALIGNMENT, 6 * fieldSize);
+    int generated = 0;
+    if (pack.Storage != NULL)
+    {
+        for (; generated < lanes; ++generated)
+        {
+            if (generateMember(options, &job->Members[job->Order[first + generated]], &bodies[generated]) != 0)
+            {
+                break;
+            }
+        }
+    }
+    if (pack.Storage == NULL || generated < lanes)
+    {
+        SDL_AddAtomicInt(&job->Failed, lanes);
+        for (int lane = 0; lane < generated; ++lane)
+        {
+            ClearObjects(&bodies[lane]);
+        }
+        SDL_aligned_free(pack.Storage);
+        return;
+    }
+
+    pack.X = (float (*)[ENSEMBLE_LANES])pack.Storage;
+    pack.Y = (float (*)[ENSEMBLE_LANES])((char *)pack.Storage + fieldSize);
+    pack.Dx = (float (*)[ENSEMBLE_LANES])((char *)pack.Storage + 2 * fieldSize);
+    pack.Dy = (float (*)[ENSEMBLE_LANES])((char *)pack.Storage + 3 * fieldSize);
+    pack.Size = (float (*)[ENSEMBLE_LANES])((char *)pack.Storage + 4 * fieldSize);
+    pack.Mass = (float (*)[ENSEMBLE_LANES])((char *)pack.Storage + 5 * fieldSize);
+    for (int lane = 0; lane < ENSEMBLE_LANES; ++lane)
+    {
+        pack.Count[lane] = lane < lanes ? bodies[lane].NumItems : 0;
+        for (int i = 0; i < pack.NumBodies; ++i)
+        {
+            /* Padding bodies sit apart on a line, so even the pairs that are thrown away never divide by zero*/
+            struct Object padding = {.x = (float)i, .mass = 1.0f};
+            const struct Object *body = i < pack.Count[lane] ? &bodies[lane].Data[i] : &padding;
+            pack.X[i][lane] = body->x;
+            pack.Y[i][lane] = body->y;
+            pack.Dx[i][lane] = body->dx;
+            pack.Dy[i][lane] = body->dy;
+            pack.Size[i][lane] = body->size;
+            pack.Mass[i][lane] = body->mass;
+        }
+    }
+
+    for (int step = 0; step < options->Steps; ++step)
+    {
+        job->Kernel(&pack, options->Dt, options->Collision);
+    }
+
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        for (int i = 0; i < bodies[lane].NumItems; ++i)
+        {
+            struct Object *body = &bodies[lane].Data[i];
+            body->x = pack.X[i][lane];
+            body->y = pack.Y[i][lane];
+            body->dx = pack.Dx[i][lane];
+            body->dy = pack.Dy[i][lane];
+        }
+        summarizeMember(&job->Members[job->Order[first + lane]], &bodies[lane]);
+        ClearObjects(&bodies[lane]);
+    }
+    SDL_aligned_free(pack.Storage);
+}
+
+/* Largest members first, then in member order. Members is the array the indices point into.*/
+static int SDLCALL compareMembers(void *Members, const void *A, const void *B)
+{
+    const struct ensembleMember *members = Members;
+    int a = *(const int *)A;
+    int b = *(const int *)B;
+    if (members[a].NumBodies != members[b].NumBodies)
+    {
+        return members[b].NumBodies - members[a].NumBodies;
+    }
+    return a - b;
+}
+
+static int writeSummary(const char *Path, const struct EnsembleOptions *Options, const struct ensembleMember *Members)
+{
+    SDL_IOStream *stream = SDL_IOFromFile(Path, "w");
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    int written = SDL_IOprintf(stream, "member,seed,bodies,steps,initial_energy,final_energy,energy_drift,momentum_x,momentum_y,center_x,center_y,radius\n") > 0;
+    for (int i = 0; i < Options->NumMembers && written; ++i)
+    {
+        const struct ensembleMember *member = &Members[i];
+        if (!member->Done)
+        {
+            continue;
+        }
+        double drift = member->InitialEnergy != 0.0 ? (member->FinalEnergy - member->InitialEnergy) / SDL_fabs(member->InitialEnergy) : 0.0;
+        written = SDL_IOprintf(stream, "%d,%" SDL_PRIu64 ",%d,%d,%.9g,%.9g,%.6g,%.9g,%.9g,%.9g,%.9g,%.9g\n", i, member->Seed, member->NumBodies,
+                               Options->Steps, member->InitialEnergy, member->FinalEnergy, drift, member->MomentumX, member->MomentumY,
+                               member->CenterX, member->CenterY, member->Radius) > 0;
+    }
+    if (!SDL_CloseIO(stream))
+    {
+        written = 0;
+    }
+    return written ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    struct EnsembleOptions options;
+    if (parseEnsembleOptions(argc, argv, &options) != 0)
+    {
+        return 1;
+    }
+
+    struct ensembleJob job;
+    SDL_zero(job);
+    job.Options = &options;
+    job.Members = SDL_calloc(options.NumMembers, sizeof(struct ensembleMember));
+    job.Order = SDL_malloc(options.NumMembers * sizeof(int));
+    struct ThreadPool pool;
+    if (job.Members == NULL || job.Order == NULL || CreateThreadPool(&pool, options.Threads) != 0)
+    {
+        SDL_Log("Couldn't set up %d members.", options.NumMembers);
+        SDL_free(job.Members);
+        SDL_free(job.Order);
+        return 1;
+    }
+
+    /* The body count comes from the member's own seed, so a member is the same whichever ensemble it is part of*/
+    Uint64 totalBodies = 0;
+    for (int i = 0; i < options.NumMembers; ++i)
+    {
+        struct ensembleMember *member = &job.Members[i];
+        member->Seed = options.Seed + (Uint64)i;
+        Uint64 state = member->Seed;
+        member->NumBodies = options.MinBodies + SDL_rand_r(&state, options.MaxBodies - options.MinBodies + 1);
+        totalBodies += (Uint64)member->NumBodies;
+        job.Order[i] = i;
+    }
+    /* Sorting by size keeps the padding of a pack small, and runs the longest jobs first*/
+    SDL_qsort_r(job.Order, options.NumMembers, sizeof(int), compareMembers, job.Members);
+
+    const char *kernelName;
+    job.Kernel = ChooseEnsembleKernel(&kernelName);
+    int numJobs = options.Lanes ? (options.NumMembers + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES : options.NumMembers;
+    char lanesNote[64] = "";
+    if (options.Lanes)
+    {
+        SDL_snprintf(lanesNote, sizeof(lanesNote), ", %d members per call of the %s kernel", ENSEMBLE_LANES, kernelName);
+    }
+    SDL_Log("Running %d %s members of %d to %d bodies for %d steps on %d threads%s", options.NumMembers, ScenarioGeneratorName(options.Generator),
+            options.MinBodies, options.MaxBodies, options.Steps, pool.NumThreads, lanesNote);
+
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    RunParallel(&pool, options.Lanes ? "ensemble packs" : "ensemble members", options.Lanes ? runPack : runMember, &job, numJobs);
+    double seconds = (SDL_GetPerformanceCounter() - startTime) / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("Ran %d members in %.2f s (%.3g body steps per second)", options.NumMembers, seconds,
+            (double)totalBodies * options.Steps / SDL_max(seconds, 1e-6));
+
+    int failed = SDL_GetAtomicInt(&job.Failed);
+    if (failed > 0)
+    {
+        SDL_Log("%d members ran out of memory and are left out of the summary", failed);
+    }
+    int result = writeSummary(options.SummaryPath, &options, job.Members);
+    if (result != 0)
+    {
+        SDL_Log("Couldn't write summary %s: %s", options.SummaryPath, SDL_GetError());
+    }
+
+    DestroyThreadPool(&pool);
+    SDL_free(job.Members);
+    SDL_free(job.Order);
+    return result == 0 && failed == 0 ? 0 : 1;
+}
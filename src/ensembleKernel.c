@@ -0,0 +1,117 @@
+#include "ensembleKernel.h"
+
+#include <SDL3/SDL_intrin.h>
+#include <math.h>
+
+#include "objects.h"
+
+/* This function advances every member of a pack by one step. Each lane does the arithmetic of calcPhysicsBetween2Objects
+   for its member in the same order, with both outcomes of a pair worked out and the right one picked per lane, so it matches
+   the scalar run bit for bit unless the compiler fuses multiplies and adds differently in the two.
+   New velocities are stored in a second loop, so the compiler need not prove the two bodies of a pair apart to vectorize.
+   It is inlined into one entry point per instruction set, so each copy is vectorized for its own target. */
+SDL_FORCE_INLINE void stepPack(struct EnsemblePack *Pack, float Dt, int Collision)
+{
+    for (int i = 0; i < Pack->NumBodies; ++i)
+    {
+        const float *x1 = Pack->X[i];
+        const float *y1 = Pack->Y[i];
+        float *dx1 = Pack->Dx[i];
+        float *dy1 = Pack->Dy[i];
+        const float *size1 = Pack->Size[i];
+        const float *mass1 = Pack->Mass[i];
+
+        for (int j = i + 1; j < Pack->NumBodies; ++j)
+        {
+            const float *x2 = Pack->X[j];
+            const float *y2 = Pack->Y[j];
+            float *dx2 = Pack->Dx[j];
+            float *dy2 = Pack->Dy[j];
+            const float *size2 = Pack->Size[j];
+            const float *mass2 = Pack->Mass[j];
+
+            float newDx1[ENSEMBLE_LANES];
+            float newDy1[ENSEMBLE_LANES];
+            float newDx2[ENSEMBLE_LANES];
+            float newDy2[ENSEMBLE_LANES];
+            for (int lane = 0; lane < ENSEMBLE_LANES; ++lane)
+            {
+                float distanceBetweenObject = sqrtf((x1[lane] - x2[lane]) * (x1[lane] - x2[lane]) + (y1[lane] - y2[lane]) * (y1[lane] - y2[lane]));
+                float m1 = mass1[lane];
+                float m2 = mass2[lane];
+
+                /* Elastic bounce*/
+                float bounceDx1 = (dx1[lane] * (m1 - m2) + 2 * m2 * dx2[lane]) / (m1 + m2);
+                float bounceDx2 = (dx2[lane] * (m2 - m1) + 2 * m1 * dx1[lane]) / (m1 + m2);
+                float bounceDy1 = (dy1[lane] * (m1 - m2) + 2 * m2 * dy2[lane]) / (m1 + m2);
+                float bounceDy2 = (dy2[lane] * (m2 - m1) + 2 * m1 * dy1[lane]) / (m1 + m2);
+
+                /* Pull*/
+                float force = GRAVITY * ((m1 * m2) / (distanceBetweenObject * distanceBetweenObject) + PAIR_ATTRACTION);
+                float invDist = 1.0f / distanceBetweenObject;
+                float directionX = (x2[lane] - x1[lane]) * invDist;
+                float directionY = (y2[lane] - y1[lane]) * invDist;
+                float selfAccel = force / m1;
+                float otherAccel = force / m2;
+                float pullDx1 = dx1[lane] + directionX * selfAccel * Dt;
+                float pullDy1 = dy1[lane] + directionY * selfAccel * Dt;
+                float pullDx2 = dx2[lane] - directionX * otherAccel * Dt;
+                float pullDy2 = dy2[lane] - directionY * otherAccel * Dt;
+
+                /* Padding bodies come last, so a pair is real when its second body is.
+                   Bitwise rather than logical operators, branches would stop the loop from being vectorized. */
+                int real = j < Pack->Count[lane];
+                int touching = distanceBetweenObject <= size1[lane] + size2[lane];
+                int bounce = real & touching & Collision;
+                int pull = real & !touching;
+                newDx1[lane] = bounce ? bounceDx1 : pull ? pullDx1 : dx1[lane];
+                newDy1[lane] = bounce ? bounceDy1 : pull ? pullDy1 : dy1[lane];
+                newDx2[lane] = bounce ? bounceDx2 : pull ? pullDx2 : dx2[lane];
+                newDy2[lane] = bounce ? bounceDy2 : pull ? pullDy2 : dy2[lane];
+            }
+            for (int lane = 0; lane < ENSEMBLE_LANES; ++lane)
+            {
+                dx1[lane] = newDx1[lane];
+                dy1[lane] = newDy1[lane];
+                dx2[lane] = newDx2[lane];
+                dy2[lane] = newDy2[lane];
+            }
+        }
+    }
+
+    for (int i = 0; i < Pack->NumBodies; ++i)
+    {
+        for (int lane = 0; lane < ENSEMBLE_LANES; ++lane)
+        {
+            Pack->X[i][lane] += Pack->Dx[i][lane] * Dt;
+            Pack->Y[i][lane] += Pack->Dy[i][lane] * Dt;
+        }
+    }
+}
+
+static void stepPackBaseline(struct EnsemblePack *Pack, float Dt, int Collision)
+{
+    stepPack(Pack, Dt, Collision);
+}
+
+#ifdef SDL_AVX2_INTRINSICS
+/* Only this function may use AVX2, the rest of the program still runs on CPUs without it. FMA stays off,
+   fused multiply-adds would make the lanes differ from the per-member path. */
+static void SDL_TARGETING("avx2") stepPackAVX2(struct EnsemblePack *Pack, float Dt, int Collision)
+{
+    stepPack(Pack, Dt, Collision);
+}
+#endif
+
+EnsembleKernel ChooseEnsembleKernel(const char **Name)
+{
+#ifdef SDL_AVX2_INTRINSICS
+    if (SDL_HasAVX2())
+    {
+        *Name = "avx2";
+        return stepPackAVX2;
+    }
+#endif
+    *Name = "baseline";
+    return stepPackBaseline;
+}
@@ -0,0 +1,32 @@
+#ifndef ENSEMBLEKERNEL_H
+#define ENSEMBLEKERNEL_H
+
+#include <SDL3/SDL.h>
+
+/* Members advanced together by one call of the interleaved kernel, 8 floats fill a 256-bit register*/
+#define ENSEMBLE_LANES 8
+#define LANE_ALIGNMENT 64
+
+/* Bodies of ENSEMBLE_LANES members, body i of every member side by side. Members with fewer bodies than the largest one
+   are padded with bodies that never move or pull. */
+struct EnsemblePack
+{
+    int NumBodies;
+    int Count[ENSEMBLE_LANES];
+    float *Storage;
+    float (*X)[ENSEMBLE_LANES];
+    float (*Y)[ENSEMBLE_LANES];
+    float (*Dx)[ENSEMBLE_LANES];
+    float (*Dy)[ENSEMBLE_LANES];
+    float (*Size)[ENSEMBLE_LANES];
+    float (*Mass)[ENSEMBLE_LANES];
+};
+
+/* Advances every member of a pack by one step*/
+typedef void (*EnsembleKernel)(struct EnsemblePack *Pack, float Dt, int Collision);
+
+/* This function returns the kernel built for the widest instruction set the CPU supports, and names it in Name.
+   On x86 that is AVX2 when available, otherwise the kernel built for the baseline target of the compiler. */
+EnsembleKernel ChooseEnsembleKernel(const char **Name);
+
+#endif
@@ -0,0 +1,113 @@
+#include "frameArena.h"
+
+/* A heap allocation made while the block was full*/
+struct arenaSpill
+{
+    struct arenaSpill *Next;
+};
+
+/* Keeps the memory after the spill header aligned*/
+#define SPILL_HEADER_SIZE ((sizeof(struct arenaSpill) + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1))
+
+int InitFrameArena(struct FrameArena *Arena, size_t Size)
+{
+    SDL_zerop(Arena);
+    Arena->Base = SDL_aligned_alloc(FRAME_ARENA_ALIGNMENT, Size);
+    if (Arena->Base == NULL)
+    {
+        return -1;
+    }
+    Arena->Size = Size;
+    return 0;
+}
+
+void *ArenaAlloc(struct FrameArena *Arena, size_t Size)
+{
+    size_t aligned = (Size + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1);
+
+    if (Arena->Used + aligned <= Arena->Size)
+    {
+        void *memory = Arena->Base + Arena->Used;
+        Arena->Used += aligned;
+        return memory;
+    }
+
+    /* Out of room for this frame, take it from the heap and remember how much was missing*/
+    struct arenaSpill *spill = SDL_aligned_alloc(FRAME_ARENA_ALIGNMENT, SPILL_HEADER_SIZE + aligned);
+    if (spill == NULL)
+    {
+        return NULL;
+    }
+    spill->Next = Arena->Spills;
+    Arena->Spills = spill;
+    Arena->SpillBytes += aligned;
+    return (Uint8 *)spill + SPILL_HEADER_SIZE;
+}
+
+static void freeSpills(struct FrameArena *Arena)
+{
+    while (Arena->Spills != NULL)
+    {
+        struct arenaSpill *next = Arena->Spills->Next;
+        SDL_aligned_free(Arena->Spills);
+        Arena->Spills = next;
+    }
+    Arena->SpillBytes = 0;
+}
+
+void ResetFrameArena(struct FrameArena *Arena)
+{
+    if (Arena->Spills != NULL)
+    {
+        size_t needed = Arena->Used + Arena->SpillBytes;
+        freeSpills(Arena);
+
+        /* Grow with some headroom so a slowly growing scene does not spill every frame*/
+        size_t newSize = needed + needed / 4;
+        Uint8 *base = SDL_aligned_alloc(FRAME_ARENA_ALIGNMENT, newSize);
+        if (base != NULL)
+        {
+            SDL_aligned_free(Arena->Base);
+            Arena->Base = base;
+            Arena->Size = newSize;
+        }
+    }
+    Arena->Used = 0;
+}
+
+void DestroyFrameArena(struct FrameArena *Arena)
+{
+    freeSpills(Arena);
+    SDL_aligned_free(Arena->Base);
+    SDL_zerop(Arena);
+}
+
+int GrowArray(struct FrameArena *Arena, void **Data, int *Capacity, int Used, int Needed, size_t ItemSize)
+{
+    if (Needed <= *Capacity)
+    {
+        return 0;
+    }
+
+    int newCapacity = SDL_max(Needed, *Capacity * 2);
+    void *ptr;
+    if (Arena != NULL)
+    {
+        ptr = ArenaAlloc(Arena, newCapacity * ItemSize);
+        if (ptr != NULL && Used > 0)
+        {
+            SDL_memcpy(ptr, *Data, Used * ItemSize);
+        }
+    }
+    else
+    {
+        ptr = SDL_realloc(*Data, newCapacity * ItemSize);
+    }
+    if (ptr == NULL)
+    {
+        return -1;
+    }
+    *Data = ptr;
+    *Capacity = newCapacity;
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <SDL3/SDL.h>
+
+/* Alignment of every arena allocation*/
+#define FRAME_ARENA_ALIGNMENT 16
+
+struct arenaSpill;
+
+/* Linear allocator for memory that only lives until the next reset, normally one frame.
+   Allocation is a pointer bump. When a frame needs more than the block holds, the extra requests are served
+   from the heap and the block is enlarged to the frame's total at the next reset, so a warmed-up arena never touches the heap. */
+struct FrameArena
+{
+    Uint8 *Base;
+    size_t Size;
+    size_t Used;
+
+    struct arenaSpill *Spills;
+    size_t SpillBytes;
+};
+
+/* This function gives the arena its first block. Returns -1 if the allocation fails.*/
+int InitFrameArena(struct FrameArena *Arena, size_t Size);
+/* This function returns Size bytes valid until the next reset, or NULL if the heap is exhausted.*/
+void *ArenaAlloc(struct FrameArena *Arena, size_t Size);
+/* This function releases everything allocated since the last reset.*/
+void ResetFrameArena(struct FrameArena *Arena);
+void DestroyFrameArena(struct FrameArena *Arena);
+
+/* This function grows an array of Used items to hold at least Needed, doubling so appends stay amortised O(1).
+   With an arena the contents move to a new arena block, the old one is reclaimed at the next reset, without one the array is reallocated.
+   Returns -1 when out of memory, the array is then unchanged. */
+int GrowArray(struct FrameArena *Arena, void **Data, int *Capacity, int Used, int Needed, size_t ItemSize);
+
+#endif
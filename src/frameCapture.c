@@ -0,0 +1,312 @@
+#include "frameCapture.h"
+#include "traceRecorder.h"
+
+#define DEFAULT_WRITERS 2
+/* Digits of the frame number in file names*/
+#define NUMBER_DIGITS 6
+
+/* This function takes the next frame in capture order, or returns -1 once capture stops and nothing is left*/
+static int takeFrame(struct FrameCapture *Capture)
+{
+    SDL_LockMutex(Capture->Lock);
+    while (Capture->QueueCount == 0 && !Capture->Quit)
+    {
+        SDL_WaitCondition(Capture->WorkReady, Capture->Lock);
+    }
+    int frame = -1;
+    if (Capture->QueueCount > 0)
+    {
+        frame = Capture->Queue[Capture->QueueHead];
+        Capture->QueueHead = (Capture->QueueHead + 1) % CAPTURE_BUFFERS;
+        --Capture->QueueCount;
+    }
+    SDL_UnlockMutex(Capture->Lock);
+    return frame;
+}
+
+static void releaseFrame(struct FrameCapture *Capture, int Frame)
+{
+    SDL_LockMutex(Capture->Lock);
+    Capture->Free[Capture->NumFree++] = Frame;
+    SDL_UnlockMutex(Capture->Lock);
+}
+
+/* This function converts pixels to packed RGB24 in a scratch buffer. Returns NULL when out of memory.*/
+static Uint8 *toRGB24(int Width, int Height, SDL_PixelFormat Format, const void *Pixels, int Pitch, Uint8 **Scratch, size_t *ScratchSize)
+{
+    size_t size = (size_t)Width * Height * 3;
+    if (size > *ScratchSize)
+    {
+        Uint8 *scratch = SDL_realloc(*Scratch, size);
+        if (scratch == NULL)
+        {
+            return NULL;
+        }
+        *Scratch = scratch;
+        *ScratchSize = size;
+    }
+    if (!SDL_ConvertPixels(Width, Height, Format, Pixels, Pitch, SDL_PIXELFORMAT_RGB24, *Scratch, Width * 3))
+    {
+        return NULL;
+    }
+    return *Scratch;
+}
+
+bool SavePPM(const char *Path, int Width, int Height, SDL_PixelFormat Format, const void *Pixels, int Pitch, Uint8 **Scratch, size_t *ScratchSize)
+{
+    Uint8 *rgb = toRGB24(Width, Height, Format, Pixels, Pitch, Scratch, ScratchSize);
+    if (rgb == NULL)
+    {
+        return false;
+    }
+    SDL_IOStream *file = SDL_IOFromFile(Path, "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    size_t size = (size_t)Width * Height * 3;
+    bool written = SDL_IOprintf(file, "P6\n%d %d\n255\n", Width, Height) > 0 && SDL_WriteIO(file, rgb, size) == size;
+    return SDL_CloseIO(file) && written;
+}
+
+static bool writeFrame(struct FrameCapture *Capture, const struct CapturedFrame *Frame, Uint8 **Scratch, size_t *ScratchSize)
+{
+    if (Capture->Format == CAPTURE_RAW)
+    {
+        Uint8 *rgb = toRGB24(Frame->Width, Frame->Height, Frame->Format, Frame->Pixels, Frame->Pitch, Scratch, ScratchSize);
+        /* The only writer of the stream, so frames land in capture order*/
+        size_t size = (size_t)Frame->Width * Frame->Height * 3;
+        return rgb != NULL && SDL_WriteIO(Capture->Stream, rgb, size) == size;
+    }
+
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s%0*" SDL_PRIu64 "%s", Capture->Prefix, NUMBER_DIGITS, Frame->Number, Capture->Extension) < 0)
+    {
+        return false;
+    }
+
+    bool written;
+    if (Capture->Format == CAPTURE_BMP)
+    {
+        SDL_Surface *surface = SDL_CreateSurfaceFrom(Frame->Width, Frame->Height, Frame->Format, Frame->Pixels, Frame->Pitch);
+        written = surface != NULL && SDL_SaveBMP(surface, path);
+        SDL_DestroySurface(surface);
+    }
+    else
+    {
+        written = SavePPM(path, Frame->Width, Frame->Height, Frame->Format, Frame->Pixels, Frame->Pitch, Scratch, ScratchSize);
+    }
+    SDL_free(path);
+    return written;
+}
+
+static int writerMain(void *Data)
+{
+    struct FrameCapture *Capture = Data;
+    SetTraceThreadName("capture writer");
+
+    /* Conversion buffer of this writer, grown to the largest frame*/
+    Uint8 *scratch = NULL;
+    size_t scratchSize = 0;
+
+    for (;;)
+    {
+        int frame = takeFrame(Capture);
+        if (frame < 0)
+        {
+            break;
+        }
+
+        TraceBegin("write frame");
+        if (!writeFrame(Capture, &Capture->Frames[frame], &scratch, &scratchSize))
+        {
+            if (SDL_AddAtomicInt(&Capture->Failed, 1) == 0)
+            {
+                SDL_Log("Couldn't write captured frame %" SDL_PRIu64 ": %s", Capture->Frames[frame].Number, SDL_GetError());
+            }
+        }
+        TraceEnd("write frame");
+        releaseFrame(Capture, frame);
+    }
+
+    SDL_free(scratch);
+    return 0;
+}
+
+int StartFrameCapture(struct FrameCapture *Capture, const char *Path, int NumWriters)
+{
+    SDL_zerop(Capture);
+
+    const char *extension = SDL_strrchr(Path, '.');
+    if (extension != NULL && SDL_strcasecmp(extension, ".ppm") == 0)
+    {
+        Capture->Format = CAPTURE_PPM;
+    }
+    else if (extension != NULL && SDL_strcasecmp(extension, ".bmp") == 0)
+    {
+        Capture->Format = CAPTURE_BMP;
+    }
+    else
+    {
+        Capture->Format = CAPTURE_RAW;
+    }
+
+    if (Capture->Format == CAPTURE_RAW)
+    {
+        Capture->Stream = SDL_IOFromFile(Path, "wb");
+        if (Capture->Stream == NULL)
+        {
+            return -1;
+        }
+        NumWriters = 1;
+    }
+    else
+    {
+        Capture->Prefix = SDL_strndup(Path, extension - Path);
+        Capture->Extension = extension;
+        if (Capture->Prefix == NULL)
+        {
+            StopFrameCapture(Capture);
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < CAPTURE_BUFFERS; ++i)
+    {
+        Capture->Free[i] = i;
+    }
+    Capture->NumFree = CAPTURE_BUFFERS;
+
+    Capture->NumWriters = NumWriters > 0 ? NumWriters : DEFAULT_WRITERS;
+    Capture->Lock = SDL_CreateMutex();
+    Capture->WorkReady = SDL_CreateCondition();
+    Capture->Writers = SDL_calloc(Capture->NumWriters, sizeof(SDL_Thread *));
+    if (Capture->Lock == NULL || Capture->WorkReady == NULL || Capture->Writers == NULL)
+    {
+        StopFrameCapture(Capture);
+        return -1;
+    }
+    for (int i = 0; i < Capture->NumWriters; ++i)
+    {
+        Capture->Writers[i] = SDL_CreateThread(writerMain, "capture writer", Capture);
+        if (Capture->Writers[i] == NULL)
+        {
+            StopFrameCapture(Capture);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void CaptureFrame(struct FrameCapture *Capture, SDL_Renderer *Renderer)
+{
+    Uint64 number = Capture->Captured + Capture->Dropped;
+
+    SDL_LockMutex(Capture->Lock);
+    int frame = Capture->NumFree > 0 ? Capture->Free[--Capture->NumFree] : -1;
+    SDL_UnlockMutex(Capture->Lock);
+    if (frame < 0)
+    {
+        /* Writers are behind, the main loop never waits for them*/
+        ++Capture->Dropped;
+        return;
+    }
+
+    /* SDL hands the pixels over in a new surface, they are copied into the reusable buffer so the writers own their memory*/
+    SDL_Surface *surface = SDL_RenderReadPixels(Renderer, NULL);
+    struct CapturedFrame *captured = &Capture->Frames[frame];
+    size_t size = surface != NULL ? (size_t)surface->pitch * surface->h : 0;
+    int fits = surface != NULL && (Capture->Format != CAPTURE_RAW || Capture->StreamWidth == 0 ||
+                                   (surface->w == Capture->StreamWidth && surface->h == Capture->StreamHeight));
+    if (fits && size > captured->Capacity)
+    {
+        Uint8 *pixels = SDL_realloc(captured->Pixels, size);
+        fits = pixels != NULL;
+        if (fits)
+        {
+            captured->Pixels = pixels;
+            captured->Capacity = size;
+        }
+    }
+    if (!fits)
+    {
+        /* A raw stream cannot change frame size, frames of another size are left out, logged once per size change*/
+        if (surface != NULL && (surface->w != Capture->SkippedWidth || surface->h != Capture->SkippedHeight))
+        {
+            SDL_Log("Captured frame is %dx%d, not %dx%d like the stream, leaving frames of this size out", surface->w, surface->h, Capture->StreamWidth, Capture->StreamHeight);
+            Capture->SkippedWidth = surface->w;
+            Capture->SkippedHeight = surface->h;
+        }
+        SDL_DestroySurface(surface);
+        releaseFrame(Capture, frame);
+        ++Capture->Dropped;
+        return;
+    }
+
+    SDL_memcpy(captured->Pixels, surface->pixels, size);
+    captured->Width = surface->w;
+    captured->Height = surface->h;
+    captured->Pitch = surface->pitch;
+    captured->Format = surface->format;
+    captured->Number = number;
+    SDL_DestroySurface(surface);
+    Capture->SkippedWidth = 0;
+    Capture->SkippedHeight = 0;
+    if (Capture->Format == CAPTURE_RAW && Capture->StreamWidth == 0)
+    {
+        Capture->StreamWidth = captured->Width;
+        Capture->StreamHeight = captured->Height;
+    }
+
+    SDL_LockMutex(Capture->Lock);
+    Capture->Queue[(Capture->QueueHead + Capture->QueueCount) % CAPTURE_BUFFERS] = frame;
+    ++Capture->QueueCount;
+    SDL_SignalCondition(Capture->WorkReady);
+    SDL_UnlockMutex(Capture->Lock);
+    ++Capture->Captured;
+}
+
+void StopFrameCapture(struct FrameCapture *Capture)
+{
+    if (Capture->Writers != NULL)
+    {
+        /* Writers finish the queue before they see Quit*/
+        SDL_LockMutex(Capture->Lock);
+        Capture->Quit = 1;
+        SDL_BroadcastCondition(Capture->WorkReady);
+        SDL_UnlockMutex(Capture->Lock);
+        for (int i = 0; i < Capture->NumWriters; ++i)
+        {
+            if (Capture->Writers[i] != NULL)
+            {
+                SDL_WaitThread(Capture->Writers[i], NULL);
+            }
+        }
+        SDL_free(Capture->Writers);
+
+        SDL_Log("Captured %" SDL_PRIu64 " frames, dropped %" SDL_PRIu64 ", %d failed to write", Capture->Captured, Capture->Dropped, SDL_GetAtomicInt(&Capture->Failed));
+        if (Capture->Format == CAPTURE_RAW && Capture->StreamWidth > 0)
+        {
+            SDL_Log("Raw stream: rgb24, %dx%d per frame", Capture->StreamWidth, Capture->StreamHeight);
+        }
+    }
+
+    if (Capture->Stream != NULL)
+    {
+        SDL_CloseIO(Capture->Stream);
+    }
+    for (int i = 0; i < CAPTURE_BUFFERS; ++i)
+    {
+        SDL_free(Capture->Frames[i].Pixels);
+    }
+    if (Capture->WorkReady != NULL)
+    {
+        SDL_DestroyCondition(Capture->WorkReady);
+    }
+    if (Capture->Lock != NULL)
+    {
+        SDL_DestroyMutex(Capture->Lock);
+    }
+    SDL_free(Capture->Prefix);
+    SDL_zerop(Capture);
+}
@@ -0,0 +1,74 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <SDL3/SDL.h>
+
+/* Frames read back and waiting for a writer. When all are taken a frame is dropped rather than waited for*/
+#define CAPTURE_BUFFERS 16
+
+/* What the captured frames become, picked from the extension of the capture path*/
+enum CaptureFormat
+{
+    CAPTURE_PPM, /* one numbered binary PPM per frame */
+    CAPTURE_BMP, /* one numbered BMP per frame */
+    CAPTURE_RAW  /* every frame appended to one stream of packed RGB24 frames */
+};
+
+/* One read back frame, in the pixel format of the renderer*/
+struct CapturedFrame
+{
+    Uint8 *Pixels;
+    size_t Capacity;
+    int Width;
+    int Height;
+    int Pitch;
+    SDL_PixelFormat Format;
+    Uint64 Number;
+};
+
+/* Reads back every rendered frame into reusable buffers and hands them to writer threads,
+   so the main loop only pays for the read back and one copy. */
+struct FrameCapture
+{
+    enum CaptureFormat Format;
+    /* Numbered files are Prefix, the frame number and Extension*/
+    char *Prefix;
+    const char *Extension;
+    /* Raw streams: the file and the frame size fixed by the first frame*/
+    SDL_IOStream *Stream;
+    int StreamWidth;
+    int StreamHeight;
+    /* Size of the last frame left out for not matching the stream, so each new size is logged once*/
+    int SkippedWidth;
+    int SkippedHeight;
+
+    int NumWriters;
+    SDL_Thread **Writers;
+    SDL_Mutex *Lock;
+    SDL_Condition *WorkReady;
+
+    struct CapturedFrame Frames[CAPTURE_BUFFERS];
+    /* Frames free for the next read back, and frames waiting for a writer in capture order*/
+    int Free[CAPTURE_BUFFERS];
+    int NumFree;
+    int Queue[CAPTURE_BUFFERS];
+    int QueueHead;
+    int QueueCount;
+    int Quit;
+
+    Uint64 Captured;
+    Uint64 Dropped;
+    SDL_AtomicInt Failed;
+};
+
+/* This function starts capturing to Path: name.ppm and name.bmp give numbered files, anything else one raw RGB24 stream.
+   NumWriters threads write numbered files (0 for the default), a raw stream always has one to keep its order. Returns -1 on failure. */
+int StartFrameCapture(struct FrameCapture *Capture, const char *Path, int NumWriters);
+/* This function reads back the frame drawn so far and queues it. Call it after drawing and before SDL_RenderPresent.*/
+void CaptureFrame(struct FrameCapture *Capture, SDL_Renderer *Renderer);
+/* This function writes the queued frames, stops the writers and logs how many frames were captured and dropped.*/
+void StopFrameCapture(struct FrameCapture *Capture);
+/* This function writes pixels of any format to Path as a binary PPM, converted in Scratch, which grows to fit. Returns false on failure.*/
+bool SavePPM(const char *Path, int Width, int Height, SDL_PixelFormat Format, const void *Pixels, int Pitch, Uint8 **Scratch, size_t *ScratchSize);
+
+#endif
@@ -0,0 +1,21 @@
+#include "frameSmoother.h"
+
+/* Weight of the newest frame in the smoothed times*/
+#define SMOOTHING 0.1f
+
+void SmoothFrameTimes(struct FrameSmoother *Smoother, float TargetMs, float IntervalMs, float BusyMs)
+{
+    /* A frame after waiting for events or a stall should not wipe out the history on its own,
+       but sustained slow frames must still pull the smoothed times up */
+    float limit = TargetMs * 4.0f;
+    IntervalMs = SDL_min(IntervalMs, limit);
+    BusyMs = SDL_min(BusyMs, limit);
+
+    if (Smoother->IntervalMs <= 0.0f)
+    {
+        Smoother->IntervalMs = IntervalMs;
+        Smoother->BusyMs = BusyMs;
+    }
+    Smoother->IntervalMs += (IntervalMs - Smoother->IntervalMs) * SMOOTHING;
+    Smoother->BusyMs += (BusyMs - Smoother->BusyMs) * SMOOTHING;
+}
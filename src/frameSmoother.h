@@ -0,0 +1,17 @@
+#ifndef FRAMESMOOTHER_H
+#define FRAMESMOOTHER_H
+
+#include <SDL3/SDL.h>
+
+/* Smoothed frame interval and busy time (everything before present) of recent frames*/
+struct FrameSmoother
+{
+    float IntervalMs;
+    float BusyMs;
+};
+
+/* This function blends the last frame into the smoothed times. The first frame seeds them.
+   Frames are clamped to 4 times TargetMs beforehand. */
+void SmoothFrameTimes(struct FrameSmoother *Smoother, float TargetMs, float IntervalMs, float BusyMs);
+
+#endif
@@ -0,0 +1,285 @@
+#include "generators.h"
+
+#define PI 3.14159265f
+
+/* Bodies per parallel job. Each job seeds its own generator from the job index, so the output does not depend on the thread count*/
+#define GENERATOR_CHUNK 4096
+
+/* Radius range of generated bodies, well below spawned ones so dense scenes do not start out colliding*/
+#define BODY_MIN_SIZE 2.0f
+#define BODY_MAX_SIZE 4.0f
+/* Central star and planet radii of the Keplerian system*/
+#define STAR_SIZE 60.0f
+#define PLANET_MIN_SIZE 2.0f
+#define PLANET_MAX_SIZE 6.0f
+
+static const char *generatorNames[GENERATOR_COUNT] = {"disk", "plummer", "kepler", "merger"};
+
+/* Position, velocity and size of a body before it becomes an Object*/
+struct bodyState
+{
+    float x;
+    float y;
+    float dx;
+    float dy;
+    float size;
+};
+
+struct generatorJob
+{
+    enum ScenarioGenerator Generator;
+    int NumBodies;
+    Uint64 Seed;
+    float CenterX;
+    float CenterY;
+
+    /* Length scale of the scene: disk scale length, Plummer radius or innermost orbit*/
+    float Scale;
+    /* Body count and mean body mass the velocities are balanced against*/
+    int SystemBodies;
+    float MeanMass;
+
+    struct Object *Bodies;
+    struct trailSample *Trails;
+};
+
+int FindScenarioGenerator(const char *Name)
+{
+    for (int i = 0; i < GENERATOR_COUNT; ++i)
+    {
+        if (SDL_strcmp(Name, generatorNames[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *ScenarioGeneratorName(enum ScenarioGenerator Generator)
+{
+    return generatorNames[Generator];
+}
+
+static float massOfSize(float Size)
+{
+    return Size * Size * PI * BODY_DENSITY;
+}
+
+/* Mean mass of bodies with a radius uniform in [Min, Max]*/
+static float meanMass(float Min, float Max)
+{
+    return PI * BODY_DENSITY * (Max * Max * Max - Min * Min * Min) / (3.0f * (Max - Min));
+}
+
+/* Uniform in (0, 1], safe to take the logarithm of*/
+static float randomOpen(Uint64 *State)
+{
+    return 1.0f - SDL_randf_r(State);
+}
+
+/* Speed of a circular orbit at radius R around EnclosedMass, made of EnclosedCount bodies, for a body of Mass.
+   Every pair also pulls with a constant PAIR_ATTRACTION, which is counted for the enclosed bodies as if they sat at the centre. */
+static float circularSpeed(float R, float EnclosedMass, float EnclosedCount, float Mass)
+{
+    if (R <= 0.0f)
+    {
+        return 0.0f;
+    }
+    float acceleration = GRAVITY * (EnclosedMass / (R * R) + PAIR_ATTRACTION * EnclosedCount / Mass);
+    return SDL_sqrtf(acceleration * R);
+}
+
+/* This function places a body of an exponential disk of scale length H and Count bodies around the origin.
+   Sense is 1 for counter-clockwise rotation and -1 for clockwise. */
+static void diskBody(Uint64 *State, float H, int Count, float MeanMass, float Sense, struct bodyState *Body)
+{
+    /* Surface density exp(-r / h) puts r * exp(-r / h) in every ring, a gamma distribution sampled from two uniforms*/
+    float r = -H * SDL_logf(randomOpen(State) * randomOpen(State));
+    float angle = SDL_randf_r(State) * 2.0f * PI;
+
+    Body->size = BODY_MIN_SIZE + SDL_randf_r(State) * (BODY_MAX_SIZE - BODY_MIN_SIZE);
+    Body->x = r * SDL_cosf(angle);
+    Body->y = r * SDL_sinf(angle);
+
+    /* Enclosed share of an exponential disk: 1 - (1 + r / h) exp(-r / h)*/
+    float enclosed = 1.0f - (1.0f + r / H) * SDL_expf(-r / H);
+    float speed = circularSpeed(r, enclosed * Count * MeanMass, enclosed * Count, massOfSize(Body->size));
+
+    /* A little random motion keeps the disk from ringing in lockstep*/
+    float jitter = 1.0f + (SDL_randf_r(State) - 0.5f) * 0.1f;
+    Body->dx = -SDL_sinf(angle) * speed * jitter * Sense;
+    Body->dy = SDL_cosf(angle) * speed * jitter * Sense;
+}
+
+static void plummerBody(Uint64 *State, float A, int Count, float MeanMass, struct bodyState *Body)
+{
+    Body->size = BODY_MIN_SIZE + SDL_randf_r(State) * (BODY_MAX_SIZE - BODY_MIN_SIZE);
+
+    /* Radius from the inverted cumulative mass, capped so a handful of bodies do not land far away*/
+    float u = SDL_max(randomOpen(State), 0.001f);
+    float r = A / SDL_sqrtf(SDL_powf(u, -2.0f / 3.0f) - 1.0f);
+    r = SDL_min(r, 20.0f * A);
+
+    /* Isotropic in three dimensions, seen face-on*/
+    float cosTheta = 2.0f * SDL_randf_r(State) - 1.0f;
+    float sinTheta = SDL_sqrtf(1.0f - cosTheta * cosTheta);
+    float phi = SDL_randf_r(State) * 2.0f * PI;
+    Body->x = r * sinTheta * SDL_cosf(phi);
+    Body->y = r * sinTheta * SDL_sinf(phi);
+
+    /* Speed as a fraction q of the local escape speed, q drawn from q^2 (1 - q^2)^3.5 by rejection*/
+    float q;
+    float g;
+    do
+    {
+        q = SDL_randf_r(State);
+        g = SDL_randf_r(State) * 0.1f;
+    } while (g > q * q * SDL_powf(1.0f - q * q, 3.5f));
+
+    /* The constant PAIR_ATTRACTION pull of the enclosed bodies dwarfs the 1/r^2 term, so it deepens the well as in circularSpeed:
+       counted as if they sat at the centre, it adds 2 * pull * r to the squared escape speed */
+    float enclosedCount = Count * r * r * r * SDL_powf(r * r + A * A, -1.5f);
+    float pull = GRAVITY * PAIR_ATTRACTION * enclosedCount / massOfSize(Body->size);
+    float escape = SDL_sqrtf(2.0f * GRAVITY * Count * MeanMass / SDL_sqrtf(r * r + A * A) + 2.0f * pull * r);
+    float speed = q * escape;
+    float velocityCosTheta = 2.0f * SDL_randf_r(State) - 1.0f;
+    float velocitySinTheta = SDL_sqrtf(1.0f - velocityCosTheta * velocityCosTheta);
+    float velocityPhi = SDL_randf_r(State) * 2.0f * PI;
+    Body->dx = speed * velocitySinTheta * SDL_cosf(velocityPhi);
+    Body->dy = speed * velocitySinTheta * SDL_sinf(velocityPhi);
+}
+
+/* This function places a planet on a circular orbit, radius log-uniform between Inner and Outer, around a star at the origin*/
+static void planetBody(Uint64 *State, float Inner, float Outer, int Count, float MeanMass, struct bodyState *Body)
+{
+    float share = SDL_randf_r(State);
+    float r = Inner * SDL_powf(Outer / Inner, share);
+    float angle = SDL_randf_r(State) * 2.0f * PI;
+
+    Body->size = PLANET_MIN_SIZE + SDL_randf_r(State) * (PLANET_MAX_SIZE - PLANET_MIN_SIZE);
+    Body->x = r * SDL_cosf(angle);
+    Body->y = r * SDL_sinf(angle);
+
+    /* The star and the planets on inner orbits*/
+    float enclosedPlanets = share * (Count - 1);
+    float speed = circularSpeed(r, massOfSize(STAR_SIZE) + enclosedPlanets * MeanMass, 1.0f + enclosedPlanets, massOfSize(Body->size));
+    Body->dx = -SDL_sinf(angle) * speed;
+    Body->dy = SDL_cosf(angle) * speed;
+}
+
+static void generateChunk(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct generatorJob *job = UserData;
+
+    /* Seeds of neighbouring jobs are spread apart so their sequences do not overlap*/
+    Uint64 state = job->Seed ^ (0x9E3779B97F4A7C15ull * (Uint64)(JobIndex + 1));
+
+    int first = JobIndex * GENERATOR_CHUNK;
+    int last = SDL_min(first + GENERATOR_CHUNK, job->NumBodies);
+    for (int i = first; i < last; ++i)
+    {
+        struct bodyState body;
+        switch (job->Generator)
+        {
+        case GENERATOR_DISK:
+            diskBody(&state, job->Scale, job->SystemBodies, job->MeanMass, 1.0f, &body);
+            break;
+        case GENERATOR_PLUMMER:
+            plummerBody(&state, job->Scale, job->SystemBodies, job->MeanMass, &body);
+            break;
+        case GENERATOR_KEPLER:
+            if (i == 0)
+            {
+                body = (struct bodyState){0.0f, 0.0f, 0.0f, 0.0f, STAR_SIZE};
+            }
+            else
+            {
+                planetBody(&state, job->Scale, job->Scale * (1.0f + 0.1f * SDL_sqrtf((float)job->NumBodies)), job->SystemBodies, job->MeanMass, &body);
+            }
+            break;
+        default:
+        {
+            /* The first half is one galaxy, the rest the other, each balanced on its own*/
+            int second = i >= (job->NumBodies + 1) / 2;
+            diskBody(&state, job->Scale, job->SystemBodies, job->MeanMass, second ? -1.0f : 1.0f, &body);
+
+            /* Start twelve scale lengths apart, on a bound approach at half the circular speed of the pair*/
+            float separation = 12.0f * job->Scale;
+            float approach = 0.5f * circularSpeed(separation, job->SystemBodies * job->MeanMass, (float)job->SystemBodies, job->MeanMass);
+            body.x += second ? separation * 0.5f : -separation * 0.5f;
+            body.dy += second ? -approach * 0.5f : approach * 0.5f;
+            break;
+        }
+        }
+
+        struct Object *object = &job->Bodies[i];
+        object->x = job->CenterX + body.x;
+        object->y = job->CenterY + body.y;
+        object->dx = body.dx;
+        object->dy = body.dy;
+        object->size = body.size;
+        object->mass = massOfSize(body.size);
+        initCirBufferWithStorage(&object->trailBuffer, NUMBER_OF_TRAIL_PARTICLES, &job->Trails[(size_t)i * NUMBER_OF_TRAIL_PARTICLES]);
+        resetTrailSampler(&object->trailSampler);
+    }
+}
+
+int GenerateScenario(struct ObjectList *Objects, struct ThreadPool *Pool, enum ScenarioGenerator Generator, int NumBodies, Uint64 Seed, float CenterX, float CenterY)
+{
+    if (NumBodies <= 0)
+    {
+        return 0;
+    }
+
+    struct generatorJob job;
+    job.Generator = Generator;
+    job.NumBodies = NumBodies;
+    job.Seed = Seed;
+    job.CenterX = CenterX;
+    job.CenterY = CenterY;
+    job.SystemBodies = NumBodies;
+    job.MeanMass = meanMass(BODY_MIN_SIZE, BODY_MAX_SIZE);
+
+    /* Scenes grow with the body count so the spacing between bodies stays about the same*/
+    float spread = SDL_sqrtf((float)NumBodies);
+    switch (Generator)
+    {
+    case GENERATOR_DISK:
+        job.Scale = 20.0f * spread;
+        break;
+    case GENERATOR_PLUMMER:
+        job.Scale = 30.0f * spread;
+        break;
+    case GENERATOR_KEPLER:
+        job.Scale = 400.0f;
+        job.MeanMass = meanMass(PLANET_MIN_SIZE, PLANET_MAX_SIZE);
+        break;
+    default:
+        job.SystemBodies = (NumBodies + 1) / 2;
+        job.Scale = 20.0f * SDL_sqrtf((float)job.SystemBodies);
+        break;
+    }
+
+    job.Trails = SDL_malloc((size_t)NumBodies * NUMBER_OF_TRAIL_PARTICLES * sizeof(struct trailSample));
+    if (job.Trails == NULL || ReserveObjects(Objects, NumBodies) != 0 || AdoptTrailStorage(Objects, job.Trails) != 0)
+    {
+        SDL_free(job.Trails);
+        return -1;
+    }
+    job.Bodies = &Objects->Data[Objects->NumItems];
+
+    int numJobs = (NumBodies + GENERATOR_CHUNK - 1) / GENERATOR_CHUNK;
+    if (Pool != NULL && numJobs > 1)
+    {
+        RunParallel(Pool, "generate", generateChunk, &job, numJobs);
+    }
+    else
+    {
+        for (int i = 0; i < numJobs; ++i)
+        {
+            generateChunk(&job, i, 0);
+        }
+    }
+    Objects->NumItems += NumBodies;
+    return 0;
+}
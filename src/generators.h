@@ -0,0 +1,27 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+#include "threadPool.h"
+
+/* Built-in initial conditions*/
+enum ScenarioGenerator
+{
+    GENERATOR_DISK,    /* rotating exponential disk on near-circular orbits */
+    GENERATOR_PLUMMER, /* Plummer sphere seen face-on, with isotropic velocities */
+    GENERATOR_KEPLER,  /* one heavy star with planets on circular orbits */
+    GENERATOR_MERGER,  /* two counter-rotating disks falling towards each other */
+    GENERATOR_COUNT
+};
+
+/* This function returns the generator called Name (disk, plummer, kepler or merger), or -1 when there is none.*/
+int FindScenarioGenerator(const char *Name);
+const char *ScenarioGeneratorName(enum ScenarioGenerator Generator);
+
+/* This function appends NumBodies bodies from a generator centred on a world position, filling them across Pool (may be NULL).
+   The same seed and count always give the same bodies, whatever the number of threads. Returns -1 when out of memory. */
+int GenerateScenario(struct ObjectList *Objects, struct ThreadPool *Pool, enum ScenarioGenerator Generator, int NumBodies, Uint64 Seed, float CenterX, float CenterY);
+
+#endif
@@ -0,0 +1,118 @@
+#include "memoryStats.h"
+
+static SDL_malloc_func nextMalloc;
+static SDL_calloc_func nextCalloc;
+static SDL_realloc_func nextRealloc;
+static SDL_free_func nextFree;
+static bool installed = false;
+
+/* Counters of the frame in progress, updated from any thread*/
+static SDL_AtomicInt currentTag = {ALLOCATION_TAG_OTHER};
+static SDL_AtomicInt allocations[ALLOCATION_TAGS];
+/* SDL has no 64-bit atomics, so the byte counts sit behind a spinlock*/
+static SDL_SpinLock bytesLock;
+static Uint64 bytes[ALLOCATION_TAGS];
+static SDL_AtomicInt frees;
+
+static struct AllocationStats lastFrame;
+
+static void countAllocation(size_t Size)
+{
+    int tag = SDL_GetAtomicInt(&currentTag);
+    SDL_AddAtomicInt(&allocations[tag], 1);
+    SDL_LockSpinlock(&bytesLock);
+    bytes[tag] += Size;
+    SDL_UnlockSpinlock(&bytesLock);
+}
+
+static void *SDLCALL countingMalloc(size_t Size)
+{
+    countAllocation(Size);
+    return nextMalloc(Size);
+}
+
+static void *SDLCALL countingCalloc(size_t Count, size_t Size)
+{
+    countAllocation(Count * Size);
+    return nextCalloc(Count, Size);
+}
+
+static void *SDLCALL countingRealloc(void *Memory, size_t Size)
+{
+    countAllocation(Size);
+    return nextRealloc(Memory, Size);
+}
+
+static void SDLCALL countingFree(void *Memory)
+{
+    if (Memory != NULL)
+    {
+        SDL_AddAtomicInt(&frees, 1);
+    }
+    nextFree(Memory);
+}
+
+bool InstallAllocationHooks(void)
+{
+    if (installed)
+    {
+        return true;
+    }
+
+    SDL_GetMemoryFunctions(&nextMalloc, &nextCalloc, &nextRealloc, &nextFree);
+    installed = SDL_SetMemoryFunctions(countingMalloc, countingCalloc, countingRealloc, countingFree);
+    return installed;
+}
+
+bool AllocationHooksInstalled(void)
+{
+    return installed;
+}
+
+void SetAllocationTag(int Tag)
+{
+    SDL_SetAtomicInt(&currentTag, Tag);
+}
+
+void EndAllocationFrame(void)
+{
+    SDL_LockSpinlock(&bytesLock);
+    for (int tag = 0; tag < ALLOCATION_TAGS; ++tag)
+    {
+        lastFrame.Allocations[tag] = SDL_SetAtomicInt(&allocations[tag], 0);
+        lastFrame.Bytes[tag] = bytes[tag];
+        bytes[tag] = 0;
+    }
+    SDL_UnlockSpinlock(&bytesLock);
+    lastFrame.Frees = SDL_SetAtomicInt(&frees, 0);
+}
+
+const struct AllocationStats *LastFrameAllocations(void)
+{
+    return &lastFrame;
+}
+
+int TotalAllocations(const struct AllocationStats *Stats)
+{
+    int total = 0;
+    for (int tag = 0; tag < ALLOCATION_TAGS; ++tag)
+    {
+        total += Stats->Allocations[tag];
+    }
+    return total;
+}
+
+Uint64 TotalAllocatedBytes(const struct AllocationStats *Stats)
+{
+    Uint64 total = 0;
+    for (int tag = 0; tag < ALLOCATION_TAGS; ++tag)
+    {
+        total += Stats->Bytes[tag];
+    }
+    return total;
+}
+
+const char *AllocationTagName(int Tag)
+{
+    return Tag < PROFILE_STAGE_COUNT ? ProfileStageName(Tag) : "other";
+}
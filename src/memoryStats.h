@@ -0,0 +1,37 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <SDL3/SDL.h>
+
+#include "profiler.h"
+
+/* Allocations are tagged with the profiler stage running when they happen, the last tag covers everything outside a stage*/
+#define ALLOCATION_TAG_OTHER PROFILE_STAGE_COUNT
+#define ALLOCATION_TAGS (PROFILE_STAGE_COUNT + 1)
+
+/* Allocation counts of one frame*/
+struct AllocationStats
+{
+    int Allocations[ALLOCATION_TAGS];
+    Uint64 Bytes[ALLOCATION_TAGS];
+    int Frees;
+};
+
+/* This function routes SDL_malloc, SDL_calloc, SDL_realloc and SDL_free through counting hooks.
+   The hooks forward to the functions installed before them, so memory allocated earlier can still be freed. */
+bool InstallAllocationHooks(void);
+bool AllocationHooksInstalled(void);
+
+/* This function sets the tag of allocations made from now on, by any thread.*/
+void SetAllocationTag(int Tag);
+
+/* This function closes the current frame: its counts become the last frame stats and counting restarts.*/
+void EndAllocationFrame(void);
+const struct AllocationStats *LastFrameAllocations(void);
+/* These functions sum the allocations and bytes of the last frame over every tag.*/
+int TotalAllocations(const struct AllocationStats *Stats);
+Uint64 TotalAllocatedBytes(const struct AllocationStats *Stats);
+/* This function names a tag: its profiler stage, or "other" for ALLOCATION_TAG_OTHER.*/
+const char *AllocationTagName(int Tag);
+
+#endif
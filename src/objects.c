@@ -7,7 +7,11 @@ int ClearObjects(struct ObjectList *WishedList)
         struct Object *obj = &WishedList->Data[i];
         if (obj->trailBuffer.buffer != NULL)
         {
-            SDL_free(obj->trailBuffer.buffer);
+            /* Shared storage is freed below, with the rest of its block*/
+            if (!obj->trailBuffer.sharedStorage)
+            {
+                SDL_free(obj->trailBuffer.buffer);
+            }
             obj->trailBuffer.buffer = NULL;
         }
         obj->trailBuffer.capacity = NUMBER_OF_TRAIL_PARTICLES;
@@ -16,12 +20,55 @@ int ClearObjects(struct ObjectList *WishedList)
         obj->trailBuffer.writePointer = 0;
     }
 
+    for (int i = 0; i < WishedList->NumTrailStorages; ++i)
+    {
+        SDL_free(WishedList->TrailStorages[i]);
+    }
+    SDL_free(WishedList->TrailStorages);
+    WishedList->TrailStorages = NULL;
+    WishedList->NumTrailStorages = 0;
+
     SDL_free(WishedList->Data);
     WishedList->Data = NULL;
     WishedList->NumItems = 0;
     WishedList->Capacity = 10;
 }
 
+int ReserveObjects(struct ObjectList *WishedList, int Count)
+{
+    if (Count > SDL_MAX_SINT32 - WishedList->NumItems)
+    {
+        return -1;
+    }
+    int needed = WishedList->NumItems + Count;
+    /* ClearObjects frees the array but leaves a capacity behind*/
+    if (WishedList->Data != NULL && needed <= WishedList->Capacity)
+    {
+        return 0;
+    }
+
+    struct Object *ptr = SDL_realloc(WishedList->Data, (size_t)needed * sizeof(struct Object));
+    if (ptr == NULL)
+    {
+        return -1;
+    }
+    WishedList->Data = ptr;
+    WishedList->Capacity = needed;
+    return 0;
+}
+
+int AdoptTrailStorage(struct ObjectList *WishedList, struct trailSample *Storage)
+{
+    struct trailSample **storages = SDL_realloc(WishedList->TrailStorages, (WishedList->NumTrailStorages + 1) * sizeof(struct trailSample *));
+    if (storages == NULL)
+    {
+        return -1;
+    }
+    storages[WishedList->NumTrailStorages++] = Storage;
+    WishedList->TrailStorages = storages;
+    return 0;
+}
+
 /* This function adds an item into a provided list. If the list is full, it would automatically reallocate room for 10 more objects.*/
 int AddObject(struct ObjectList *WishedList, struct Object PassedObject)
 {
@@ -2,9 +2,18 @@
 #define OBJECTS_H
 
 #include "circularBuffer.h"
+#include "trail.h"
 #include <stddef.h>
 
 #define NUMBER_OF_TRAIL_PARTICLES 150
+/* Width and height of a trail particle in world units, trail samples only store its centre */
+#define TRAIL_PARTICLE_SIZE 2.0f
+
+/* Pull between two bodies: GRAVITY * (m1 * m2 / r^2 + PAIR_ATTRACTION), see calcPhysicsBetween2Objects*/
+#define GRAVITY 1000.0f
+#define PAIR_ATTRACTION 50.0f
+/* Mass per unit of disc area, a body of radius r weighs r * r * PI * BODY_DENSITY*/
+#define BODY_DENSITY 8.0f
 
 /* This structure defines an Object.*/
 struct Object
@@ -19,6 +28,7 @@ struct Object
     float mass;
 
     struct cirBuffer trailBuffer;
+    struct TrailSampler trailSampler;
 };
 
 /* This structure defines an Object container, used to contain objects. */
@@ -27,11 +37,19 @@ struct ObjectList
     int NumItems;
     int Capacity;
     struct Object *Data;
+
+    /* Trail storage of objects added in bulk, one allocation per batch, freed with the list */
+    int NumTrailStorages;
+    struct trailSample **TrailStorages;
 };
 
 /* This function adds an item into a provided list. If the list is full, it would automatically reallocate room for 10 more objects.*/
 int AddObject(struct ObjectList *WishedList, struct Object PassedObject);
 int ClearObjects(struct ObjectList *WishedList);
+/* This function makes room for Count more objects at once, so bulk loads do not grow the list 10 objects at a time.*/
+int ReserveObjects(struct ObjectList *WishedList, int Count);
+/* This function hands a block of trail samples, shared by objects about to be added, over to the list. Returns -1 when out of memory, the block is then still the caller's.*/
+int AdoptTrailStorage(struct ObjectList *WishedList, struct trailSample *Storage);
 
 
 
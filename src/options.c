@@ -0,0 +1,176 @@
+#include "options.h"
+
+#include <SDL3/SDL.h>
+
+static void logUsage(const char *Program)
+{
+    SDL_Log("Usage: %s [options]\n"
+            "  --scenario FILE       start with the bodies of FILE: lines of x,y,dx,dy,radius[,mass], or a binary GMSB body list\n"
+            "  --generate NAME       start with a generated scene: disk, plummer, kepler or merger\n"
+            "  --bodies N            bodies made by --generate (default 10000)\n"
+            "  --seed N              seed of --generate, the same seed gives the same scene (default 1)\n"
+            "  --checkpoint BASE     write the bodies to BASE.0.gmsb, BASE.1.gmsb and BASE.2.gmsb in turn, in the background\n"
+            "  --checkpoint-every N  simulation steps between checkpoints (default 1000)\n"
+            "  --restart             resume from the newest valid checkpoint (of BASE, or of \"checkpoint\")\n"
+            "  --trace FILE          record a Chrome trace of every frame stage and worker job, written to FILE at exit (T writes it on demand)\n"
+            "  --alloc-stats         count allocations per frame and per stage, shown in the profiler overlay\n"
+            "  --alloc-check FRAMES  like --alloc-stats, and report (and assert on) any frame after the first FRAMES that allocates (not with --capture)\n"
+            "  --perf-counters       count cycles, instructions, cache and branch misses per stage with perf_event_open (Linux), logged at exit\n"
+            "  --benchmark FRAMES    disable VSync, fly the camera path for FRAMES frames, log frame time statistics and exit\n"
+            "  --benchmark-bodies N  bodies spawned when the benchmark starts with an empty scene (default 1000)\n"
+            "  --camera-path FILE    camera path flown by --benchmark instead of the built-in one\n"
+            "  --record-camera FILE  write the camera of every frame to FILE at exit, for --camera-path\n"
+            "  --capture PATH        write every frame: PATH name.ppm or name.bmp gives name000000.ppm and so on, any other name one raw RGB24 stream\n"
+            "  --capture-writers N   threads writing numbered capture files (default 2)\n"
+            "  --trajectory FILE     record the bodies of every simulated frame to FILE, for replay to render offline\n"
+            "  --trajectory-every N  simulated frames between recorded ones (default 1)\n"
+            "  --render-scale S      draw the scene at S (0.5 - 1) times the window resolution, or auto to adapt it to the frame target\n"
+            "  --frame-target MS     frame time --render-scale auto and --quality-governor aim for (default 16.7)\n"
+            "  --quality-governor    lower trail length, circle detail and physics substeps under load, and restore them with headroom",
+            Program);
+}
+
+int ParseOptions(int argc, char *argv[], struct AppOptions *Options)
+{
+    SDL_zerop(Options);
+    Options->GeneratorBodies = 10000;
+    Options->GeneratorSeed = 1;
+    Options->CheckpointEvery = 1000;
+    Options->TrajectoryEvery = 1;
+    Options->BenchmarkBodies = 1000;
+    Options->RenderScale = 1.0f;
+    Options->FrameTargetMs = 1000.0f / 60.0f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        /* Value of options that take one*/
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(argv[i], "--scenario") == 0 && value != NULL)
+        {
+            Options->ScenarioFile = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--generate") == 0 && value != NULL)
+        {
+            Options->GeneratorName = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--bodies") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->GeneratorBodies = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--seed") == 0 && value != NULL)
+        {
+            Options->GeneratorSeed = SDL_strtoull(value, NULL, 0);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--checkpoint") == 0 && value != NULL)
+        {
+            Options->CheckpointBase = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--checkpoint-every") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->CheckpointEvery = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--restart") == 0)
+        {
+            Options->Restart = 1;
+        }
+        else if (SDL_strcmp(argv[i], "--trace") == 0 && value != NULL)
+        {
+            Options->TracePath = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--alloc-stats") == 0)
+        {
+            Options->AllocationStats = 1;
+        }
+        else if (SDL_strcmp(argv[i], "--perf-counters") == 0)
+        {
+            Options->PerfCounters = 1;
+        }
+        else if (SDL_strcmp(argv[i], "--alloc-check") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->AllocationStats = 1;
+            Options->AllocationCheckAfter = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--benchmark") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->BenchmarkFrames = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--benchmark-bodies") == 0 && value != NULL && SDL_atoi(value) >= 0)
+        {
+            Options->BenchmarkBodies = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--camera-path") == 0 && value != NULL)
+        {
+            Options->CameraPathFile = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--record-camera") == 0 && value != NULL)
+        {
+            Options->RecordCameraFile = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--capture") == 0 && value != NULL)
+        {
+            Options->CapturePath = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--capture-writers") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->CaptureWriters = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--trajectory") == 0 && value != NULL)
+        {
+            Options->TrajectoryPath = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--trajectory-every") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->TrajectoryEvery = SDL_atoi(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--quality-governor") == 0)
+        {
+            Options->QualityGovernor = 1;
+        }
+        else if (SDL_strcmp(argv[i], "--render-scale") == 0 && value != NULL && SDL_strcmp(value, "auto") == 0)
+        {
+            Options->DynamicRenderScale = 1;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--render-scale") == 0 && value != NULL && SDL_atof(value) >= 0.5 && SDL_atof(value) <= 1.0)
+        {
+            Options->RenderScale = (float)SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--frame-target") == 0 && value != NULL && SDL_atof(value) > 0.0)
+        {
+            Options->FrameTargetMs = (float)SDL_atof(value);
+            ++i;
+        }
+        else
+        {
+            SDL_Log("Unknown or incomplete option: %s", argv[i]);
+            logUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    /* Reading back a frame allocates a new surface every time, which the check would report on every frame*/
+    if (Options->AllocationCheckAfter > 0 && Options->CapturePath != NULL)
+    {
+        SDL_Log("--alloc-check cannot be combined with --capture, capture allocates every frame");
+        return -1;
+    }
+    return 0;
+}
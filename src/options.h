@@ -0,0 +1,63 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <SDL3/SDL_stdinc.h>
+
+/* Settings taken from the command line*/
+struct AppOptions
+{
+    /* Text or binary body list loaded at startup, NULL to start with an empty scene */
+    const char *ScenarioFile;
+    /* Built-in generator (disk, plummer, kepler or merger) filling the scene with GeneratorBodies bodies from GeneratorSeed, NULL for none */
+    const char *GeneratorName;
+    int GeneratorBodies;
+    Uint64 GeneratorSeed;
+
+    /* Bodies written every CheckpointEvery simulation steps to rotating files under CheckpointBase, NULL when off */
+    const char *CheckpointBase;
+    int CheckpointEvery;
+    /* Resume from the newest valid checkpoint under CheckpointBase (or the default base) instead of building a scene */
+    int Restart;
+
+    /* Chrome trace-event JSON written at exit, NULL when tracing is off */
+    const char *TracePath;
+
+    /* Count allocations through SDL_SetMemoryFunctions hooks */
+    int AllocationStats;
+    /* When above 0, report every frame after this many that still allocates */
+    int AllocationCheckAfter;
+
+    /* Read hardware counters around every profiler stage and log them at exit (Linux only) */
+    int PerfCounters;
+
+    /* When above 0, run this many frames without VSync along a camera path, log the frame times and exit */
+    int BenchmarkFrames;
+    /* Bodies spawned for a benchmark that starts with an empty scene */
+    int BenchmarkBodies;
+    /* Camera path flown by the benchmark, NULL for the built-in one */
+    const char *CameraPathFile;
+    /* Camera of every frame written here at exit, to fly it again with --camera-path */
+    const char *RecordCameraFile;
+
+    /* Every frame read back and written by CaptureWriters threads to numbered .ppm or .bmp files, or one raw RGB24 stream, NULL when off */
+    const char *CapturePath;
+    int CaptureWriters;
+
+    /* Body positions written every TrajectoryEvery simulated frames, to render later with the replay tool, NULL when off */
+    const char *TrajectoryPath;
+    int TrajectoryEvery;
+
+    /* Fraction of the window resolution the scene is drawn at, the HUD stays native */
+    float RenderScale;
+    /* Set by --render-scale auto: the scale follows the frame times to stay under FrameTargetMs */
+    int DynamicRenderScale;
+    float FrameTargetMs;
+
+    /* Trade trail length, circle detail, level of detail thresholds and physics substeps for frame time to stay under FrameTargetMs */
+    int QualityGovernor;
+};
+
+/* This function fills Options from the command line. Returns -1 and logs the usage on an unknown or incomplete argument.*/
+int ParseOptions(int argc, char *argv[], struct AppOptions *Options);
+
+#endif
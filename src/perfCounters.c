@@ -0,0 +1,185 @@
+#include "perfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *eventNames[PERF_EVENT_COUNT] = {"cycles", "instructions", "L1d misses", "LLC misses", "branch misses"};
+
+/* Raw counts of the group, with the time it was enabled and the time it actually ran on the counters*/
+struct perfSample
+{
+    Uint64 Enabled;
+    Uint64 Running;
+    Uint64 Values[PERF_EVENT_COUNT];
+};
+
+/* Totals per stage, summed over the whole run*/
+static Uint64 stageTotals[PROFILE_STAGE_COUNT][PERF_EVENT_COUNT];
+static struct perfSample stageStart[PROFILE_STAGE_COUNT];
+/* False when the start of a stage could not be read, its end then adds nothing*/
+static bool stageStarted[PROFILE_STAGE_COUNT];
+static bool opened = false;
+
+#ifdef __linux__
+static int groupFd = -1;
+static int eventFds[PERF_EVENT_COUNT];
+
+static int openEvent(Uint32 Type, Uint64 Config, int Leader)
+{
+    struct perf_event_attr attr;
+    SDL_zero(attr);
+    attr.size = sizeof(attr);
+    attr.type = Type;
+    attr.config = Config;
+    attr.disabled = Leader < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, Leader, 0);
+}
+
+/* This function reads the whole group at once, unscaled: multiplexing is accounted for per stage, see EndPerfStage*/
+static bool readCounters(struct perfSample *Sample)
+{
+    Uint64 buffer[3 + PERF_EVENT_COUNT];
+    if (read(groupFd, buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer))
+    {
+        return false;
+    }
+
+    Sample->Enabled = buffer[1];
+    Sample->Running = buffer[2];
+    SDL_memcpy(Sample->Values, buffer + 3, sizeof(Sample->Values));
+    return true;
+}
+#endif
+
+bool OpenPerfCounters(void)
+{
+#ifdef __linux__
+    static const Uint32 types[PERF_EVENT_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+    static const Uint64 configs[PERF_EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i)
+    {
+        eventFds[i] = openEvent(types[i], configs[i], i == 0 ? -1 : groupFd);
+        if (eventFds[i] < 0)
+        {
+            SDL_SetError("perf_event_open failed for %s (check /proc/sys/kernel/perf_event_paranoid)", eventNames[i]);
+            for (int j = 0; j < i; ++j)
+            {
+                close(eventFds[j]);
+            }
+            groupFd = -1;
+            return false;
+        }
+        if (i == 0)
+        {
+            groupFd = eventFds[0];
+        }
+    }
+
+    ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    opened = true;
+    return true;
+#else
+    SDL_SetError("Hardware performance counters are only supported on Linux");
+    return false;
+#endif
+}
+
+bool PerfCountersOpen(void)
+{
+    return opened;
+}
+
+void ClosePerfCounters(void)
+{
+#ifdef __linux__
+    if (opened)
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i)
+        {
+            close(eventFds[i]);
+        }
+        groupFd = -1;
+    }
+#endif
+    opened = false;
+}
+
+void BeginPerfStage(enum ProfileStage Stage)
+{
+#ifdef __linux__
+    stageStarted[Stage] = opened && readCounters(&stageStart[Stage]);
+#endif
+}
+
+void EndPerfStage(enum ProfileStage Stage)
+{
+#ifdef __linux__
+    struct perfSample now;
+    const struct perfSample *start = &stageStart[Stage];
+    /* If the kernel multiplexed the counters, the raw counts of the stage are scaled up by the share of
+       the stage they were running for. A stage during which they never ran adds nothing. */
+    if (opened && stageStarted[Stage] && readCounters(&now) && now.Running > start->Running)
+    {
+        double scale = (double)(now.Enabled - start->Enabled) / (double)(now.Running - start->Running);
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i)
+        {
+            stageTotals[Stage][i] += (Uint64)((double)(now.Values[i] - start->Values[i]) * scale);
+        }
+    }
+    stageStarted[Stage] = false;
+#endif
+}
+
+void LogPerfCounters(Uint64 Steps, Uint64 SimulatedFrames, Uint64 Frames, Uint64 Interactions)
+{
+    if (!opened || Frames == 0)
+    {
+        return;
+    }
+
+    SDL_Log("Hardware counters over %" SDL_PRIu64 " steps, %" SDL_PRIu64 " simulated frames and %" SDL_PRIu64 " frames:", Steps, SimulatedFrames, Frames);
+    SDL_Log("%-14s %-5s %14s %14s %6s %12s %12s %12s", "stage", "per", eventNames[PERF_CYCLES], eventNames[PERF_INSTRUCTIONS], "IPC",
+            eventNames[PERF_L1D_MISSES], eventNames[PERF_LLC_MISSES], eventNames[PERF_BRANCH_MISSES]);
+
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+    {
+        /* Forces and integration run once per substep, trails once per unpaused frame, the rest once per frame*/
+        int perStep = stage == PROFILE_FORCES || stage == PROFILE_INTEGRATION;
+        int perSimulatedFrame = stage == PROFILE_TRAIL_WRITES;
+        double count = (double)(perStep ? Steps : perSimulatedFrame ? SimulatedFrames : Frames);
+        if (count == 0.0)
+        {
+            continue;
+        }
+
+        const Uint64 *totals = stageTotals[stage];
+        double ipc = totals[PERF_CYCLES] > 0 ? (double)totals[PERF_INSTRUCTIONS] / (double)totals[PERF_CYCLES] : 0.0;
+        SDL_Log("%-14s %-5s %14.0f %14.0f %6.2f %12.0f %12.0f %12.0f", ProfileStageName(stage), perStep ? "step" : perSimulatedFrame ? "sim" : "frame",
+                totals[PERF_CYCLES] / count, totals[PERF_INSTRUCTIONS] / count, ipc,
+                totals[PERF_L1D_MISSES] / count, totals[PERF_LLC_MISSES] / count, totals[PERF_BRANCH_MISSES] / count);
+    }
+
+    if (Interactions > 0)
+    {
+        const Uint64 *forces = stageTotals[PROFILE_FORCES];
+        SDL_Log("Force stage per pair interaction (%" SDL_PRIu64 " pairs): %.2f cycles, %.2f instructions, %.4f L1d misses, %.4f LLC misses, %.4f branch misses",
+                Interactions,
+                (double)forces[PERF_CYCLES] / Interactions, (double)forces[PERF_INSTRUCTIONS] / Interactions,
+                (double)forces[PERF_L1D_MISSES] / Interactions, (double)forces[PERF_LLC_MISSES] / Interactions,
+                (double)forces[PERF_BRANCH_MISSES] / Interactions);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <SDL3/SDL.h>
+
+#include "profiler.h"
+
+/* Hardware events counted per stage*/
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+/* This function opens the counters of the calling thread through perf_event_open. Linux only, returns false elsewhere or when the kernel refuses.*/
+bool OpenPerfCounters(void);
+bool PerfCountersOpen(void);
+void ClosePerfCounters(void);
+
+/* These functions add the events between them to a profiler stage. The profiler calls them, they do nothing while the counters are closed.*/
+void BeginPerfStage(enum ProfileStage Stage);
+void EndPerfStage(enum ProfileStage Stage);
+
+/* This function logs the counts of the physics stages per step, of trail writes per simulated frame, of the other stages per frame,
+   and of the force stage per pair interaction. */
+void LogPerfCounters(Uint64 Steps, Uint64 SimulatedFrames, Uint64 Frames, Uint64 Interactions);
+
+#endif
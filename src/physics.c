@@ -0,0 +1,54 @@
+#include "physics.h"
+
+#include <math.h>
+
+float distance(float x1, float y1, float x2, float y2)
+{
+    return sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+}
+
+void calcPhysicsBetween2Objects(struct Object *selfObject, struct Object *otherObject, float dt, int Collision)
+{
+    float distanceBetweenObject = distance(otherObject->x, otherObject->y, selfObject->x, selfObject->y);
+
+    if (distanceBetweenObject <= selfObject->size + otherObject->size) // Collision, neuron activation, DOPAMINE RELEASED
+    {
+        if (!Collision)
+        {
+            return;
+        }
+
+        float m1 = selfObject->mass;
+        float m2 = otherObject->mass;
+
+        // 1D elastic collision formula for dx (repeat for dy)
+        float newDx1 = (selfObject->dx * (m1 - m2) + 2 * m2 * otherObject->dx) / (m1 + m2);
+        float newDx2 = (otherObject->dx * (m2 - m1) + 2 * m1 * selfObject->dx) / (m1 + m2);
+
+        float newDy1 = (selfObject->dy * (m1 - m2) + 2 * m2 * otherObject->dy) / (m1 + m2);
+        float newDy2 = (otherObject->dy * (m2 - m1) + 2 * m1 * selfObject->dy) / (m1 + m2);
+
+        selfObject->dx = newDx1;
+        selfObject->dy = newDy1;
+        otherObject->dx = newDx2;
+        otherObject->dy = newDy2;
+        return;
+    }
+
+    /* Newton's Law of Universal Gravitation*/
+    float force = GRAVITY * ((selfObject->mass * otherObject->mass) / (distanceBetweenObject * distanceBetweenObject) + PAIR_ATTRACTION);
+
+    /* Normalizing DirectionX and DirectionY*/
+    float invDist = 1.0f / distanceBetweenObject;
+    float directionX = (otherObject->x - selfObject->x) * invDist;
+    float directionY = (otherObject->y - selfObject->y) * invDist;
+
+    /* Finding acceleration with a formula derived from Newton's second law */
+    float selfAccel = force / selfObject->mass;
+    selfObject->dx += directionX * selfAccel * dt;
+    selfObject->dy += directionY * selfAccel * dt;
+
+    float otherAccel = force / otherObject->mass;
+    otherObject->dx -= directionX * otherAccel * dt;
+    otherObject->dy -= directionY * otherAccel * dt;
+}
@@ -0,0 +1,12 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "objects.h"
+
+/* This function calculates the distance between 2 points using Pythagorean theorem*/
+float distance(float x1, float y1, float x2, float y2);
+/* This function applies the pull, or when they touch and Collision is set the elastic bounce, between two objects over dt.
+   Shared by the simulation and the ensemble runner so both integrate the same physics. */
+void calcPhysicsBetween2Objects(struct Object *selfObject, struct Object *otherObject, float dt, int Collision);
+
+#endif
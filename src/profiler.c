@@ -0,0 +1,172 @@
+#include "profiler.h"
+#include "traceRecorder.h"
+#include "memoryStats.h"
+#include "perfCounters.h"
+
+/* Vertical scale of the bars*/
+#define PROFILER_PIXELS_PER_MS 6.0f
+#define PROFILER_GRAPH_HEIGHT 200.0f
+#define PROFILER_OVERLAY_WIDTH 460.0f
+
+static const char *stageNames[PROFILE_STAGE_COUNT] = {
+    "forces", "integration", "trail writes", "spatial index", "trail render", "body render", "text", "present"};
+
+static const SDL_Color stageColors[PROFILE_STAGE_COUNT] = {
+    {230, 80, 60, 255}, {240, 160, 40, 255}, {230, 220, 60, 255}, {200, 120, 200, 255}, {80, 200, 90, 255},
+    {60, 170, 230, 255}, {150, 110, 230, 255}, {120, 120, 120, 255}};
+
+/* Ticks spent per stage and per frame, the last slot of each row being the whole frame*/
+static Uint64 history[PROFILER_HISTORY][PROFILE_STAGE_COUNT + 1];
+static int currentFrame = 0;
+static int recordedFrames = 0;
+
+static Uint64 frameStart;
+static Uint64 stageStart[PROFILE_STAGE_COUNT];
+
+void BeginProfileFrame(void)
+{
+    currentFrame = (currentFrame + 1) % PROFILER_HISTORY;
+    SDL_memset(history[currentFrame], 0, sizeof(history[currentFrame]));
+    frameStart = SDL_GetPerformanceCounter();
+    TraceBegin("frame");
+}
+
+void EndProfileFrame(void)
+{
+    history[currentFrame][PROFILE_STAGE_COUNT] = SDL_GetPerformanceCounter() - frameStart;
+    TraceEnd("frame");
+    if (recordedFrames < PROFILER_HISTORY)
+    {
+        ++recordedFrames;
+    }
+}
+
+void BeginProfileStage(enum ProfileStage Stage)
+{
+    TraceBegin(stageNames[Stage]);
+    SetAllocationTag(Stage);
+    BeginPerfStage(Stage);
+    stageStart[Stage] = SDL_GetPerformanceCounter();
+}
+
+void EndProfileStage(enum ProfileStage Stage)
+{
+    history[currentFrame][Stage] += SDL_GetPerformanceCounter() - stageStart[Stage];
+    EndPerfStage(Stage);
+    SetAllocationTag(ALLOCATION_TAG_OTHER);
+    TraceEnd(stageNames[Stage]);
+}
+
+const char *ProfileStageName(enum ProfileStage Stage)
+{
+    return Stage < PROFILE_STAGE_COUNT ? stageNames[Stage] : "frame";
+}
+
+static int compareTicks(const void *a, const void *b)
+{
+    Uint64 left = *(const Uint64 *)a;
+    Uint64 right = *(const Uint64 *)b;
+    return (left > right) - (left < right);
+}
+
+/* This function converts performance counter ticks to milliseconds*/
+static float ticksToMs(Uint64 Ticks)
+{
+    return (float)((double)Ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+float ProfilePercentile(enum ProfileStage Stage, float Percentile)
+{
+    /* Only completed frames, the current one is still being measured*/
+    static Uint64 sorted[PROFILER_HISTORY];
+    int count = 0;
+    for (int i = 1; i <= recordedFrames; ++i)
+    {
+        int frame = (currentFrame - i + PROFILER_HISTORY) % PROFILER_HISTORY;
+        if (frame == currentFrame)
+        {
+            continue;
+        }
+        sorted[count++] = history[frame][Stage];
+    }
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+
+    SDL_qsort(sorted, count, sizeof(Uint64), compareTicks);
+    int rank = SDL_clamp((int)(Percentile / 100.0f * (count - 1) + 0.5f), 0, count - 1);
+    return ticksToMs(sorted[rank]);
+}
+
+void RenderProfilerOverlay(SDL_Renderer *Renderer, float x, float y)
+{
+    static SDL_FRect bars[PROFILER_HISTORY];
+
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(Renderer, &r, &g, &b, &a);
+
+    float tableY = y + PROFILER_GRAPH_HEIGHT + 8.0f;
+    float lineHeight = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE + 4.0f;
+
+    SDL_FRect background = {x - 4.0f, y - 4.0f, PROFILER_OVERLAY_WIDTH + 8.0f, PROFILER_GRAPH_HEIGHT + 16.0f + lineHeight * (PROFILE_STAGE_COUNT + 2)};
+    SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(Renderer, &background);
+
+    /* Stacked bars of the completed frames, oldest on the left, one fill call per stage*/
+    float stackHeight[PROFILER_HISTORY] = {0};
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+    {
+        int count = 0;
+        for (int i = 0; i < recordedFrames; ++i)
+        {
+            int frame = (currentFrame - recordedFrames + i + PROFILER_HISTORY) % PROFILER_HISTORY;
+            if (frame == currentFrame)
+            {
+                continue;
+            }
+            float height = ticksToMs(history[frame][stage]) * PROFILER_PIXELS_PER_MS;
+            float base = stackHeight[i];
+            stackHeight[i] += height;
+
+            if (height <= 0.0f || base >= PROFILER_GRAPH_HEIGHT)
+            {
+                continue;
+            }
+            height = SDL_min(height, PROFILER_GRAPH_HEIGHT - base);
+            bars[count++] = (SDL_FRect){x + PROFILER_HISTORY - recordedFrames + i, y + PROFILER_GRAPH_HEIGHT - base - height, 1.0f, height};
+        }
+
+        SDL_Color color = stageColors[stage];
+        SDL_SetRenderDrawColor(Renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(Renderer, bars, count);
+
+        SDL_RenderFillRect(Renderer, &(SDL_FRect){x, tableY + lineHeight * (stage + 1), 6.0f, 6.0f});
+    }
+
+    /* 60 Hz budget line*/
+    SDL_SetRenderDrawColor(Renderer, 255, 255, 255, 120);
+    SDL_RenderLine(Renderer, x, y + PROFILER_GRAPH_HEIGHT - 16.6f * PROFILER_PIXELS_PER_MS, x + PROFILER_HISTORY, y + PROFILER_GRAPH_HEIGHT - 16.6f * PROFILER_PIXELS_PER_MS);
+
+    SDL_SetRenderDrawColor(Renderer, 255, 255, 255, 255);
+    /* With the allocation hooks in place, the last frame's allocations and bytes per stage go in extra columns*/
+    const struct AllocationStats *allocations = LastFrameAllocations();
+    int showAllocations = AllocationHooksInstalled();
+
+    SDL_RenderDebugText(Renderer, x + 10.0f, tableY, showAllocations ? "stage            p50    p95    p99 ms allocs      bytes" : "stage            p50    p95    p99 ms");
+    for (int stage = 0; stage <= PROFILE_STAGE_COUNT; ++stage)
+    {
+        float rowY = tableY + lineHeight * (stage + 1);
+        SDL_RenderDebugTextFormat(Renderer, x + 10.0f, rowY, "%-13s %6.2f %6.2f %6.2f",
+                                  ProfileStageName(stage),
+                                  ProfilePercentile(stage, 50.0f), ProfilePercentile(stage, 95.0f), ProfilePercentile(stage, 99.0f));
+        if (showAllocations)
+        {
+            int count = stage < PROFILE_STAGE_COUNT ? allocations->Allocations[stage] : TotalAllocations(allocations);
+            Uint64 bytes = stage < PROFILE_STAGE_COUNT ? allocations->Bytes[stage] : TotalAllocatedBytes(allocations);
+            SDL_RenderDebugTextFormat(Renderer, x + 10.0f + 37 * SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE, rowY, "%6d %10" SDL_PRIu64, count, bytes);
+        }
+    }
+
+    SDL_SetRenderDrawColor(Renderer, r, g, b, a);
+}
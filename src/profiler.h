@@ -0,0 +1,38 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL3/SDL.h>
+
+/* Number of frames kept for the overlay and the percentiles*/
+#define PROFILER_HISTORY 240
+
+/* Instrumented parts of a frame*/
+enum ProfileStage
+{
+    PROFILE_FORCES,
+    PROFILE_INTEGRATION,
+    PROFILE_TRAIL_WRITES,
+    PROFILE_SPATIAL_INDEX,
+    PROFILE_TRAIL_RENDER,
+    PROFILE_BODY_RENDER,
+    PROFILE_TEXT,
+    PROFILE_PRESENT,
+    PROFILE_STAGE_COUNT
+};
+
+/* This function starts a new frame in the history ring.*/
+void BeginProfileFrame(void);
+/* This function closes the current frame and records its total duration.*/
+void EndProfileFrame(void);
+/* These functions time one stage. A stage may be entered several times per frame, the durations add up.*/
+void BeginProfileStage(enum ProfileStage Stage);
+void EndProfileStage(enum ProfileStage Stage);
+
+/* This function returns the given percentile (0-100) of a stage over the history in milliseconds, or of the whole frame when Stage is PROFILE_STAGE_COUNT.*/
+float ProfilePercentile(enum ProfileStage Stage, float Percentile);
+const char *ProfileStageName(enum ProfileStage Stage);
+
+/* This function draws stacked per-stage bars of the recent frames and a p50/p95/p99 table.*/
+void RenderProfilerOverlay(SDL_Renderer *Renderer, float x, float y);
+
+#endif
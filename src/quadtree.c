@@ -0,0 +1,169 @@
+#include "quadtree.h"
+#include "frameArena.h"
+
+/* This function moves the indices whose body passes the test to the front of the range and returns how many did*/
+static int partition(int *Indices, int Count, const struct ObjectList *Objects, int ByX, float Split)
+{
+    int front = 0;
+    for (int i = 0; i < Count; ++i)
+    {
+        const struct Object *obj = &Objects->Data[Indices[i]];
+        if ((ByX ? obj->x : obj->y) < Split)
+        {
+            int swap = Indices[front];
+            Indices[front] = Indices[i];
+            Indices[i] = swap;
+            ++front;
+        }
+    }
+    return front;
+}
+
+/* This function creates the node for a range of indices inside a square cell and all of its descendants. Returns the node index or -1.*/
+static int buildNode(struct Quadtree *Tree, const struct ObjectList *Objects, int First, int Count, float CentreX, float CentreY, float Half, int Depth)
+{
+    if (GrowArray(NULL, (void **)&Tree->Nodes, &Tree->NodeCapacity, Tree->NumNodes, Tree->NumNodes + 1, sizeof(struct QuadtreeNode)) != 0)
+    {
+        return -1;
+    }
+    int nodeIndex = Tree->NumNodes++;
+    struct QuadtreeNode node = {.First = First, .Count = Count, .Child = {-1, -1, -1, -1}};
+
+    if (Count > QUADTREE_LEAF_SIZE && Depth < QUADTREE_MAX_DEPTH)
+    {
+        /* Split into quadrants: first by y, then each half by x*/
+        int *indices = &Tree->Indices[First];
+        int top = partition(indices, Count, Objects, 0, CentreY);
+        int ranges[5] = {0, 0, top, 0, Count};
+        ranges[1] = partition(indices, top, Objects, 1, CentreX);
+        ranges[3] = top + partition(indices + top, Count - top, Objects, 1, CentreX);
+
+        float quarter = Half * 0.5f;
+        for (int q = 0; q < 4; ++q)
+        {
+            int childCount = ranges[q + 1] - ranges[q];
+            if (childCount == 0)
+            {
+                continue;
+            }
+            float childX = CentreX + (q & 1 ? quarter : -quarter);
+            float childY = CentreY + (q & 2 ? quarter : -quarter);
+            int child = buildNode(Tree, Objects, First + ranges[q], childCount, childX, childY, quarter, Depth + 1);
+            if (child < 0)
+            {
+                return -1;
+            }
+            node.Child[q] = child;
+        }
+    }
+
+    /* Gather the totals from the members directly, which is cheap next to the partitioning above*/
+    float weightedX = 0.0f;
+    float weightedY = 0.0f;
+    for (int i = 0; i < Count; ++i)
+    {
+        const struct Object *obj = &Objects->Data[Tree->Indices[First + i]];
+        if (i == 0)
+        {
+            node.MinX = obj->x - obj->size, node.MinY = obj->y - obj->size;
+            node.MaxX = obj->x + obj->size, node.MaxY = obj->y + obj->size;
+        }
+        node.MinX = SDL_min(node.MinX, obj->x - obj->size);
+        node.MinY = SDL_min(node.MinY, obj->y - obj->size);
+        node.MaxX = SDL_max(node.MaxX, obj->x + obj->size);
+        node.MaxY = SDL_max(node.MaxY, obj->y + obj->size);
+        node.Mass += obj->mass;
+        weightedX += obj->x * obj->mass;
+        weightedY += obj->y * obj->mass;
+    }
+    node.ComX = node.Mass > 0.0f ? weightedX / node.Mass : (node.MinX + node.MaxX) * 0.5f;
+    node.ComY = node.Mass > 0.0f ? weightedY / node.Mass : (node.MinY + node.MaxY) * 0.5f;
+
+    Tree->Nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+int BuildQuadtree(struct Quadtree *Tree, const struct ObjectList *Objects)
+{
+    Tree->NumNodes = 0;
+    if (Objects->NumItems == 0)
+    {
+        return 0;
+    }
+
+    if (GrowArray(NULL, (void **)&Tree->Indices, &Tree->IndexCapacity, 0, Objects->NumItems, sizeof(int)) != 0)
+    {
+        return -1;
+    }
+
+    float minX = Objects->Data[0].x, minY = Objects->Data[0].y;
+    float maxX = minX, maxY = minY;
+    for (int i = 0; i < Objects->NumItems; ++i)
+    {
+        Tree->Indices[i] = i;
+        minX = SDL_min(minX, Objects->Data[i].x);
+        minY = SDL_min(minY, Objects->Data[i].y);
+        maxX = SDL_max(maxX, Objects->Data[i].x);
+        maxY = SDL_max(maxY, Objects->Data[i].y);
+    }
+
+    float half = SDL_max(SDL_max(maxX - minX, maxY - minY) * 0.5f, 1.0f);
+    return buildNode(Tree, Objects, 0, Objects->NumItems, (minX + maxX) * 0.5f, (minY + maxY) * 0.5f, half, 0) < 0 ? -1 : 0;
+}
+
+void WalkQuadtree(const struct Quadtree *Tree, const struct View *Camera, float AggregatePixels, QuadtreeLeafVisitor VisitLeaf, QuadtreeAggregateVisitor VisitAggregate, void *UserData)
+{
+    if (Tree->NumNodes == 0)
+    {
+        return;
+    }
+
+    /* Camera rectangle in world space*/
+    float viewMinX = Camera->RootX - Camera->Width / Camera->Zoom;
+    float viewMinY = Camera->RootY - Camera->Height / Camera->Zoom;
+    float viewMaxX = Camera->RootX;
+    float viewMaxY = Camera->RootY;
+
+    /* Depth first, so every level leaves at most 3 siblings waiting on the stack*/
+    int stack[QUADTREE_MAX_DEPTH * 3 + 4];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const struct QuadtreeNode *node = &Tree->Nodes[stack[--top]];
+
+        if (node->MaxX < viewMinX || node->MinX > viewMaxX || node->MaxY < viewMinY || node->MinY > viewMaxY)
+        {
+            continue;
+        }
+
+        float projected = SDL_max(node->MaxX - node->MinX, node->MaxY - node->MinY) * Camera->Zoom;
+        if (node->Count > 1 && projected < AggregatePixels)
+        {
+            VisitAggregate(UserData, node);
+            continue;
+        }
+
+        if (node->Child[0] < 0 && node->Child[1] < 0 && node->Child[2] < 0 && node->Child[3] < 0)
+        {
+            VisitLeaf(UserData, &Tree->Indices[node->First], node->Count);
+            continue;
+        }
+
+        for (int q = 0; q < 4; ++q)
+        {
+            if (node->Child[q] >= 0)
+            {
+                stack[top++] = node->Child[q];
+            }
+        }
+    }
+}
+
+void ClearQuadtree(struct Quadtree *Tree)
+{
+    SDL_free(Tree->Nodes);
+    SDL_free(Tree->Indices);
+    SDL_zerop(Tree);
+}
@@ -0,0 +1,51 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include "objects.h"
+#include "view.h"
+
+/* Nodes with at most this many bodies are not split further*/
+#define QUADTREE_LEAF_SIZE 8
+/* Splitting stops at this depth, so bodies sharing a position cannot recurse forever*/
+#define QUADTREE_MAX_DEPTH 24
+
+/* A quadtree node. Its bodies are the range [First, First + Count) of the tree's index array. */
+struct QuadtreeNode
+{
+    /* Bounds of the member discs*/
+    float MinX;
+    float MinY;
+    float MaxX;
+    float MaxY;
+
+    float Mass;
+    float ComX; /* centre of mass */
+    float ComY;
+
+    int First;
+    int Count;
+    int Child[4]; /* -1 when the quadrant is empty, all -1 for a leaf */
+};
+
+struct Quadtree
+{
+    int NumNodes;
+    int NodeCapacity;
+    struct QuadtreeNode *Nodes;
+
+    int IndexCapacity;
+    int *Indices;
+};
+
+/* Called for a leaf that is visible and large enough to show its members*/
+typedef void (*QuadtreeLeafVisitor)(void *UserData, const int *Indices, int Count);
+/* Called for a visible node too small on screen to show its members, with its total mass and centre of mass*/
+typedef void (*QuadtreeAggregateVisitor)(void *UserData, const struct QuadtreeNode *Node);
+
+/* This function rebuilds the tree from the current bodies. Returns -1 if the allocation fails.*/
+int BuildQuadtree(struct Quadtree *Tree, const struct ObjectList *Objects);
+/* This function walks the nodes overlapping the view, descending only into nodes at least AggregatePixels across on screen.*/
+void WalkQuadtree(const struct Quadtree *Tree, const struct View *Camera, float AggregatePixels, QuadtreeLeafVisitor VisitLeaf, QuadtreeAggregateVisitor VisitAggregate, void *UserData);
+void ClearQuadtree(struct Quadtree *Tree);
+
+#endif
@@ -0,0 +1,53 @@
+#include "qualityGovernor.h"
+
+/* Frames to wait after a change before stepping down again, and before stepping back up*/
+#define DOWN_SETTLE_FRAMES 30
+#define UP_SETTLE_FRAMES 120
+
+/* From best to cheapest. The second step is what the application uses without the governor,
+   the first spends spare time on a second physics substep. */
+static const struct QualitySettings ladder[QUALITY_LEVELS] = {
+    {150, 0, 1.0f, 12.0f, 2.0f, 2},
+    {150, 0, 1.0f, 12.0f, 2.0f, 1},
+    {100, 1, 1.5f, 16.0f, 3.0f, 1},
+    {60, 2, 2.0f, 24.0f, 4.0f, 1},
+    {30, 3, 3.0f, 32.0f, 6.0f, 1},
+    {10, 4, 4.0f, 48.0f, 8.0f, 1},
+};
+
+void InitQualityGovernor(struct QualityGovernor *Governor, float TargetMs)
+{
+    SDL_zerop(Governor);
+    Governor->TargetMs = TargetMs;
+    Governor->Level = QUALITY_DEFAULT_LEVEL;
+}
+
+bool UpdateQualityGovernor(struct QualityGovernor *Governor, float IntervalMs, float BusyMs)
+{
+    SmoothFrameTimes(&Governor->Times, Governor->TargetMs, IntervalMs, BusyMs);
+    ++Governor->FramesSinceChange;
+
+    /* With VSync the interval never drops under the refresh period, so headroom is judged on the busy time*/
+    int level = Governor->Level;
+    if (Governor->Times.IntervalMs > Governor->TargetMs * 1.1f && Governor->FramesSinceChange >= DOWN_SETTLE_FRAMES)
+    {
+        level = SDL_min(level + 1, QUALITY_LEVELS - 1);
+    }
+    else if (Governor->Times.BusyMs < Governor->TargetMs * 0.5f && Governor->FramesSinceChange >= UP_SETTLE_FRAMES)
+    {
+        level = SDL_max(level - 1, 0);
+    }
+
+    if (level == Governor->Level)
+    {
+        return false;
+    }
+    Governor->Level = level;
+    Governor->FramesSinceChange = 0;
+    return true;
+}
+
+const struct QualitySettings *QualityLevelSettings(int Level)
+{
+    return &ladder[SDL_clamp(Level, 0, QUALITY_LEVELS - 1)];
+}
@@ -0,0 +1,46 @@
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+#include <SDL3/SDL.h>
+
+#include "frameSmoother.h"
+
+/* Number of steps on the quality ladder, 0 is the best*/
+#define QUALITY_LEVELS 6
+/* Step of the ladder matching the settings the application starts with*/
+#define QUALITY_DEFAULT_LEVEL 1
+
+/* Quality knobs of one step of the ladder*/
+struct QualitySettings
+{
+    /* Newest trail samples drawn per body, at most NUMBER_OF_TRAIL_PARTICLES*/
+    int TrailLength;
+    /* Circle detail levels dropped, see SetCircleDetailBias*/
+    int CircleDetailBias;
+    /* Level of detail thresholds in on-screen pixels, as lodPointRadius, lodSpriteRadius and lodTrailSpacing*/
+    float PointRadius;
+    float SpriteRadius;
+    float TrailSpacing;
+    /* Physics steps per frame, each over an equal share of the frame time*/
+    int PhysicsSubsteps;
+};
+
+/* Walks the quality ladder to keep frames under a time budget: one step down when frames run over it,
+   one step up when they leave plenty of headroom. Changes are spaced out so the smoothed times can follow. */
+struct QualityGovernor
+{
+    float TargetMs;
+    int Level;
+
+    struct FrameSmoother Times;
+    int FramesSinceChange;
+};
+
+/* This function starts the governor at the default step.*/
+void InitQualityGovernor(struct QualityGovernor *Governor, float TargetMs);
+/* This function feeds the frame interval and busy time of the last frame. Returns true when the level changed.*/
+bool UpdateQualityGovernor(struct QualityGovernor *Governor, float IntervalMs, float BusyMs);
+/* This function returns the knobs of a step of the ladder.*/
+const struct QualitySettings *QualityLevelSettings(int Level);
+
+#endif
@@ -0,0 +1,99 @@
+#include "renderScale.h"
+
+/* Scale change per adjustment, and frames to wait before the next one so the smoothed times catch up*/
+#define SCALE_STEP 0.05f
+#define SCALE_SETTLE_FRAMES 30
+
+int BeginScaledScene(SDL_Renderer *Renderer, struct RenderScale *Scale, int WindowWidth, int WindowHeight)
+{
+    if (Scale->Scale >= RENDER_SCALE_MAX)
+    {
+        return 0;
+    }
+
+    int width = SDL_max((int)SDL_ceilf(WindowWidth * Scale->Scale), 1);
+    int height = SDL_max((int)SDL_ceilf(WindowHeight * Scale->Scale), 1);
+    if (Scale->Target == NULL || Scale->TargetWidth != width || Scale->TargetHeight != height)
+    {
+        if (Scale->Target != NULL)
+        {
+            SDL_DestroyTexture(Scale->Target);
+        }
+        Scale->Target = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (Scale->Target == NULL)
+        {
+            Scale->TargetWidth = 0;
+            Scale->TargetHeight = 0;
+            return -1;
+        }
+        SDL_SetTextureScaleMode(Scale->Target, SDL_SCALEMODE_LINEAR);
+        /* The scene is opaque, stretching it over the window is a plain copy*/
+        SDL_SetTextureBlendMode(Scale->Target, SDL_BLENDMODE_NONE);
+        Scale->TargetWidth = width;
+        Scale->TargetHeight = height;
+    }
+
+    if (!SDL_SetRenderTarget(Renderer, Scale->Target))
+    {
+        return -1;
+    }
+    /* The target keeps this scale as its own, the window goes back to 1 when it is selected again*/
+    SDL_SetRenderScale(Renderer, width / (float)WindowWidth, height / (float)WindowHeight);
+    return 0;
+}
+
+void EndScaledScene(SDL_Renderer *Renderer, struct RenderScale *Scale)
+{
+    if (Scale->Target == NULL || SDL_GetRenderTarget(Renderer) != Scale->Target)
+    {
+        return;
+    }
+
+    SDL_SetRenderTarget(Renderer, NULL);
+    SDL_RenderTexture(Renderer, Scale->Target, NULL, NULL);
+}
+
+bool UpdateRenderScale(struct RenderScale *Scale, float IntervalMs, float BusyMs)
+{
+    if (Scale->TargetMs <= 0.0f)
+    {
+        return false;
+    }
+    SmoothFrameTimes(&Scale->Times, Scale->TargetMs, IntervalMs, BusyMs);
+
+    if (++Scale->FramesSinceChange < SCALE_SETTLE_FRAMES)
+    {
+        return false;
+    }
+
+    /* With VSync the interval never drops under the refresh period, so headroom is judged on the busy time*/
+    float scale = Scale->Scale;
+    if (Scale->Times.IntervalMs > Scale->TargetMs * 1.1f)
+    {
+        scale -= SCALE_STEP;
+    }
+    else if (Scale->Times.BusyMs < Scale->TargetMs * 0.6f)
+    {
+        scale += SCALE_STEP;
+    }
+    scale = SDL_clamp(scale, RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+
+    if (scale == Scale->Scale)
+    {
+        return false;
+    }
+    Scale->Scale = scale;
+    Scale->FramesSinceChange = 0;
+    return true;
+}
+
+void DestroyRenderScale(struct RenderScale *Scale)
+{
+    if (Scale->Target != NULL)
+    {
+        SDL_DestroyTexture(Scale->Target);
+    }
+    Scale->Target = NULL;
+    Scale->TargetWidth = 0;
+    Scale->TargetHeight = 0;
+}
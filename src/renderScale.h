@@ -0,0 +1,37 @@
+#ifndef RENDERSCALE_H
+#define RENDERSCALE_H
+
+#include <SDL3/SDL.h>
+
+#include "frameSmoother.h"
+
+/* Range of the render scale, as a fraction of the window resolution*/
+#define RENDER_SCALE_MIN 0.5f
+#define RENDER_SCALE_MAX 1.0f
+
+/* Draws the scene into an offscreen target smaller than the window and stretches it over the window afterwards.
+   The renderer scale is set while the scene is drawn, so scene code keeps using window coordinates. */
+struct RenderScale
+{
+    /* Fraction of the window resolution the scene is drawn at*/
+    float Scale;
+
+    /* When above 0, Scale follows the frame times to keep frames under this many milliseconds*/
+    float TargetMs;
+    struct FrameSmoother Times;
+    int FramesSinceChange;
+
+    SDL_Texture *Target;
+    int TargetWidth;
+    int TargetHeight;
+};
+
+/* This function starts a frame: with a scale below 1 it redirects drawing to the offscreen target. Returns -1 on failure, drawing then goes to the window.*/
+int BeginScaledScene(SDL_Renderer *Renderer, struct RenderScale *Scale, int WindowWidth, int WindowHeight);
+/* This function returns drawing to the window and stretches the scene over it, HUD drawn after it stays at native resolution.*/
+void EndScaledScene(SDL_Renderer *Renderer, struct RenderScale *Scale);
+/* This function feeds the frame interval and busy time of the last frame to the dynamic scale. Returns true when the scale changed.*/
+bool UpdateRenderScale(struct RenderScale *Scale, float IntervalMs, float BusyMs);
+void DestroyRenderScale(struct RenderScale *Scale);
+
+#endif
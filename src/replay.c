@@ -0,0 +1,590 @@
+/* Renders a trajectory recorded with --trajectory to numbered image files, without running any physics.
+   SDL renderers belong to the main thread, so frames are drawn there with one software renderer,
+   and every batch of drawn frames is converted and written by the thread pool side by side. */
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+
+#include "trajectory.h"
+#include "sceneRender.h"
+#include "circle.h"
+#include "discSprite.h"
+#include "threadPool.h"
+#include "frameArena.h"
+#include "benchmark.h"
+#include "frameCapture.h"
+
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+#define DEFAULT_FPS 60.0
+#define FRAME_ARENA_SIZE (4 * 1024 * 1024)
+/* Digits of the frame number in file names*/
+#define NUMBER_DIGITS 6
+/* Room left around the bodies of the first frame when the camera is fitted to them*/
+#define FIT_MARGIN 1.1f
+/* Recorded frames sampled into the trails ahead of the first output frame, the samples before them have normally left every trail*/
+#define TRAIL_WARMUP_FRAMES (8 * TRAJECTORY_KEYFRAME_INTERVAL)
+
+struct ReplayOptions
+{
+    const char *TrajectoryFile;
+    const char *OutputPath;
+    int Width;
+    int Height;
+
+    /* Output frames per second, and simulated seconds per second of output*/
+    double FramesPerSecond;
+    double Speed;
+    /* Simulated time range to render, EndTime below 0 for the end of the recording*/
+    double StartTime;
+    double EndTime;
+
+    /* Camera path flown over the whole output, or a fixed camera: fitted to the first frame unless a centre or zoom is given*/
+    const char *CameraPathFile;
+    int FixedCenter;
+    float CenterX;
+    float CenterY;
+    float Zoom;
+
+    enum BodyRenderMode Mode;
+    int TrailLength;
+    int Threads;
+};
+
+/* A drawn output frame waiting to be written*/
+struct renderedFrame
+{
+    Uint8 *Pixels;
+    int Number;
+};
+
+struct replayJob
+{
+    const struct ReplayOptions *Options;
+    const struct Trajectory *Trajectory;
+    const struct CameraPath *CameraPath;
+    struct CameraKey Camera;
+
+    /* Numbered files are Prefix, the frame number and Extension*/
+    char *Prefix;
+    const char *Extension;
+    int Bitmap;
+
+    int NumFrames;
+    /* The surface frames are drawn into, and copies of it waiting for the pool, at most one per thread*/
+    SDL_Surface *Surface;
+    struct renderedFrame *Batch;
+    int BatchCapacity;
+    int NumBatched;
+    /* Buffers the frames are converted in before writing, one per pool thread*/
+    Uint8 **Scratch;
+    size_t *ScratchSize;
+    SDL_AtomicInt Failed;
+};
+
+static void logUsage(const char *Program)
+{
+    SDL_Log("Usage: %s [options] TRAJECTORY OUTPUT\n"
+            "  Renders a trajectory written with --trajectory. OUTPUT name.ppm or name.bmp gives name000000.ppm and so on.\n"
+            "  --size WxH            resolution of the frames (default 1920x1080)\n"
+            "  --fps N               output frames per second (default 60)\n"
+            "  --speed X             simulated seconds per second of output (default 1)\n"
+            "  --start S             simulated time of the first frame (default the start of the recording)\n"
+            "  --end S               simulated time of the last frame (default the end of the recording)\n"
+            "  --camera-path FILE    camera path, as written by --record-camera, flown over the whole output\n"
+            "  --center X,Y          world position at the centre of every frame (default the centre of the first frame's bodies)\n"
+            "  --zoom Z              pixels per world unit (default fitted to the first frame's bodies)\n"
+            "  --mode MODE           how bodies are drawn: auto, geometry or sprite (default auto)\n"
+            "  --trail N             trail samples drawn per body, 0 for none (default 150)\n"
+            "  --threads N           threads writing frames (default one per logical core)",
+            Program);
+}
+
+static int parseReplayOptions(int argc, char *argv[], struct ReplayOptions *Options)
+{
+    SDL_zerop(Options);
+    Options->Width = DEFAULT_WIDTH;
+    Options->Height = DEFAULT_HEIGHT;
+    Options->FramesPerSecond = DEFAULT_FPS;
+    Options->Speed = 1.0;
+    Options->EndTime = -1.0;
+    Options->Mode = BODY_RENDER_AUTO;
+    Options->TrailLength = NUMBER_OF_TRAIL_PARTICLES;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        /* Value of options that take one*/
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(argv[i], "--size") == 0 && value != NULL &&
+            SDL_sscanf(value, "%dx%d", &Options->Width, &Options->Height) == 2 && Options->Width > 0 && Options->Height > 0)
+        {
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--fps") == 0 && value != NULL && SDL_atof(value) > 0.0)
+        {
+            Options->FramesPerSecond = SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--speed") == 0 && value != NULL && SDL_atof(value) > 0.0)
+        {
+            Options->Speed = SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--start") == 0 && value != NULL)
+        {
+            Options->StartTime = SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--end") == 0 && value != NULL && SDL_atof(value) >= 0.0)
+        {
+            Options->EndTime = SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--camera-path") == 0 && value != NULL)
+        {
+            Options->CameraPathFile = value;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--center") == 0 && value != NULL &&
+                 SDL_sscanf(value, "%f,%f", &Options->CenterX, &Options->CenterY) == 2)
+        {
+            Options->FixedCenter = 1;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--zoom") == 0 && value != NULL && SDL_atof(value) > 0.0)
+        {
+            Options->Zoom = (float)SDL_atof(value);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--mode") == 0 && value != NULL &&
+                 (SDL_strcmp(value, "auto") == 0 || SDL_strcmp(value, "geometry") == 0 || SDL_strcmp(value, "sprite") == 0))
+        {
+            Options->Mode = SDL_strcmp(value, "auto") == 0 ? BODY_RENDER_AUTO : SDL_strcmp(value, "geometry") == 0 ? BODY_RENDER_GEOMETRY
+                                                                                                                    : BODY_RENDER_SPRITE;
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--trail") == 0 && value != NULL && SDL_atoi(value) >= 0)
+        {
+            Options->TrailLength = SDL_min(SDL_atoi(value), NUMBER_OF_TRAIL_PARTICLES);
+            ++i;
+        }
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && value != NULL && SDL_atoi(value) > 0)
+        {
+            Options->Threads = SDL_atoi(value);
+            ++i;
+        }
+        else if (argv[i][0] != '-' && Options->TrajectoryFile == NULL)
+        {
+            Options->TrajectoryFile = argv[i];
+        }
+        else if (argv[i][0] != '-' && Options->OutputPath == NULL)
+        {
+            Options->OutputPath = argv[i];
+        }
+        else
+        {
+            SDL_Log("Unknown or incomplete option: %s", argv[i]);
+            logUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (Options->TrajectoryFile == NULL || Options->OutputPath == NULL)
+    {
+        logUsage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+/* This function frames the bodies of a recorded frame, with the centre and zoom given on the command line taking precedence*/
+static struct CameraKey fitCamera(const struct ReplayOptions *Options, const struct TrajectoryCursor *Frame)
+{
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    for (int i = 0; i < Frame->NumBodies; ++i)
+    {
+        float x = Frame->X[i];
+        float y = Frame->Y[i];
+        float size = Frame->Size[i];
+        if (i == 0)
+        {
+            minX = x - size;
+            minY = y - size;
+            maxX = x + size;
+            maxY = y + size;
+        }
+        minX = SDL_min(minX, x - size);
+        minY = SDL_min(minY, y - size);
+        maxX = SDL_max(maxX, x + size);
+        maxY = SDL_max(maxY, y + size);
+    }
+
+    struct CameraKey camera;
+    camera.CameraX = Options->FixedCenter ? Options->CenterX : (minX + maxX) * 0.5f;
+    camera.CameraY = Options->FixedCenter ? Options->CenterY : (minY + maxY) * 0.5f;
+    camera.Zoom = Options->Zoom;
+    if (camera.Zoom <= 0.0f)
+    {
+        float width = SDL_max(maxX - minX, 1.0f) * FIT_MARGIN;
+        float height = SDL_max(maxY - minY, 1.0f) * FIT_MARGIN;
+        camera.Zoom = SDL_min(Options->Width / width, Options->Height / height);
+    }
+    return camera;
+}
+
+/* This function makes the body list match the bodies of a recorded frame. New bodies start without a trail,
+   and fewer bodies than before means the scene was cleared, so every trail starts over. Returns -1 when out of memory. */
+static int syncBodies(struct ObjectList *Bodies, const struct TrajectoryCursor *Frame)
+{
+    if (Frame->NumBodies < Bodies->NumItems)
+    {
+        ClearObjects(Bodies);
+    }
+    int added = Frame->NumBodies - Bodies->NumItems;
+    if (added == 0)
+    {
+        return 0;
+    }
+
+    struct trailSample *trails = SDL_malloc((size_t)added * NUMBER_OF_TRAIL_PARTICLES * sizeof(struct trailSample));
+    if (trails == NULL || ReserveObjects(Bodies, added) != 0 || AdoptTrailStorage(Bodies, trails) != 0)
+    {
+        SDL_free(trails);
+        return -1;
+    }
+    for (int i = 0; i < added; ++i)
+    {
+        struct Object *body = &Bodies->Data[Bodies->NumItems + i];
+        SDL_zerop(body);
+        initCirBufferWithStorage(&body->trailBuffer, NUMBER_OF_TRAIL_PARTICLES, &trails[(size_t)i * NUMBER_OF_TRAIL_PARTICLES]);
+        resetTrailSampler(&body->trailSampler);
+    }
+    Bodies->NumItems = Frame->NumBodies;
+    return 0;
+}
+
+/* This function moves the bodies to a recorded frame and samples their trails, as the simulation does after every frame*/
+static void advanceBodies(struct ObjectList *Bodies, const struct TrajectoryCursor *Frame)
+{
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        struct Object *body = &Bodies->Data[i];
+        body->x = Frame->X[i];
+        body->y = Frame->Y[i];
+        body->size = Frame->Size[i];
+        sampleTrail(&body->trailSampler, &body->trailBuffer, body->x, body->y);
+    }
+}
+
+/* This function places the bodies between two recorded frames of the same bodies, T from 0 at From to 1 at To*/
+static void interpolateBodies(struct ObjectList *Bodies, const struct TrajectoryCursor *From, const struct TrajectoryCursor *To, float T)
+{
+    for (int i = 0; i < Bodies->NumItems; ++i)
+    {
+        Bodies->Data[i].x = From->X[i] + (To->X[i] - From->X[i]) * T;
+        Bodies->Data[i].y = From->Y[i] + (To->Y[i] - From->Y[i]) * T;
+    }
+}
+
+/* This function writes one frame of the batch, converting it with the scratch buffer of the thread*/
+static void writeFrame(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct replayJob *job = UserData;
+    const struct renderedFrame *frame = &job->Batch[JobIndex];
+    const SDL_Surface *surface = job->Surface;
+
+    char *path = NULL;
+    bool written = false;
+    if (SDL_asprintf(&path, "%s%0*d%s", job->Prefix, NUMBER_DIGITS, frame->Number, job->Extension) >= 0)
+    {
+        if (job->Bitmap)
+        {
+            SDL_Surface *copy = SDL_CreateSurfaceFrom(surface->w, surface->h, surface->format, frame->Pixels, surface->pitch);
+            written = copy != NULL && SDL_SaveBMP(copy, path);
+            SDL_DestroySurface(copy);
+        }
+        else
+        {
+            written = SavePPM(path, surface->w, surface->h, surface->format, frame->Pixels, surface->pitch, &job->Scratch[ThreadIndex],
+                              &job->ScratchSize[ThreadIndex]);
+        }
+        SDL_free(path);
+    }
+    if (!written && SDL_AddAtomicInt(&job->Failed, 1) == 0)
+    {
+        SDL_Log("Couldn't write frame %d: %s", frame->Number, SDL_GetError());
+    }
+}
+
+/* This function copies the drawn frame into the batch, and has the pool write the batch once it is full or the frame is the last one*/
+static void queueFrame(struct replayJob *Job, struct ThreadPool *Pool, int Number)
+{
+    struct renderedFrame *frame = &Job->Batch[Job->NumBatched++];
+    SDL_memcpy(frame->Pixels, Job->Surface->pixels, (size_t)Job->Surface->pitch * Job->Surface->h);
+    frame->Number = Number;
+    if (Job->NumBatched == Job->BatchCapacity || Number == Job->NumFrames - 1)
+    {
+        RunParallel(Pool, "write frames", writeFrame, Job, Job->NumBatched);
+        Job->NumBatched = 0;
+    }
+}
+
+/* This function renders every output frame on the calling thread and queues it for writing. Returns -1 on the first failure.*/
+static int renderFrames(struct replayJob *Job, struct ThreadPool *Pool, SDL_Renderer *Renderer, struct SceneRenderer *Scene,
+                        struct FrameArena *Arena, struct ObjectList *Bodies)
+{
+    const struct ReplayOptions *options = Job->Options;
+    const struct Trajectory *trajectory = Job->Trajectory;
+    int result = 0;
+
+    /* The recorded frame the trails have reached, and the one after it to move towards, both decoded straight from the mapped file*/
+    struct TrajectoryCursor frame;
+    struct TrajectoryCursor next;
+    SDL_zero(frame);
+    SDL_zero(next);
+
+    /* Trails are built like the simulation builds them, one sample per recorded frame. They start at a keyframe a little ahead of
+       the first output frame rather than at the start of the recording, so a late --start doesn't replay the whole file. */
+    int sampled = FindTrajectoryFrame(trajectory, options->StartTime);
+    sampled = trajectory->Index[SDL_max(sampled - TRAIL_WARMUP_FRAMES, 0)].Keyframe;
+    for (int i = 0; i < Job->NumFrames && result == 0 && SDL_GetAtomicInt(&Job->Failed) == 0; ++i)
+    {
+        double time = options->StartTime + i * options->Speed / options->FramesPerSecond;
+        int current = FindTrajectoryFrame(trajectory, time);
+        for (; sampled <= current; ++sampled)
+        {
+            if (SeekTrajectory(trajectory, &frame, sampled) != 0)
+            {
+                result = -1;
+                break;
+            }
+            if (syncBodies(Bodies, &frame) != 0)
+            {
+                SDL_SetError("out of memory for %d bodies", frame.NumBodies);
+                result = -1;
+                break;
+            }
+            advanceBodies(Bodies, &frame);
+        }
+        if (result != 0)
+        {
+            break;
+        }
+
+        /* Between recorded frames the bodies move in a straight line, unless bodies were added or removed in between*/
+        if (current + 1 < trajectory->NumFrames && time > frame.Time && trajectory->Index[current + 1].NumBodies == frame.NumBodies)
+        {
+            if (SeekTrajectory(trajectory, &next, current + 1) != 0)
+            {
+                result = -1;
+                break;
+            }
+            interpolateBodies(Bodies, &frame, &next, (float)SDL_min((time - frame.Time) / (next.Time - frame.Time), 1.0));
+        }
+
+        struct CameraKey camera = Job->Camera;
+        if (Job->CameraPath->NumKeys > 0)
+        {
+            camera = SampleCameraPath(Job->CameraPath, Job->NumFrames > 1 ? i / (float)(Job->NumFrames - 1) : 0.0f);
+        }
+        Scene->View = (struct View){camera.CameraX + options->Width * 0.5f / camera.Zoom, camera.CameraY + options->Height * 0.5f / camera.Zoom,
+                                    camera.Zoom, options->Width, options->Height};
+
+        ResetFrameArena(Arena);
+        BindSceneRenderer(Scene, Arena);
+        SDL_SetRenderDrawColor(Renderer, 1, 1, 1, SDL_ALPHA_OPAQUE);
+        SDL_RenderClear(Renderer);
+        SDL_SetRenderDrawColor(Renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+
+        /* Every body is drawn on its own, clusters are not merged like they are on screen*/
+        if (Scene->TrailLength > 0)
+        {
+            for (int body = 0; body < Bodies->NumItems; ++body)
+            {
+                AddTrailToScene(Scene, &Bodies->Data[body]);
+            }
+            FlushSceneTrails(Renderer, Scene);
+        }
+        for (int body = 0; body < Bodies->NumItems; ++body)
+        {
+            AddBodyToScene(Scene, &Bodies->Data[body]);
+        }
+        FlushSceneBodies(Renderer, Scene);
+
+        /* The surface only holds the frame once the queued draw calls have run*/
+        if (!SDL_FlushRenderer(Renderer))
+        {
+            result = -1;
+            break;
+        }
+        queueFrame(Job, Pool, i);
+    }
+
+    ClearTrajectoryCursor(&frame);
+    ClearTrajectoryCursor(&next);
+    return result;
+}
+
+/* This function sets up the renderer and the batch of frames to write, then renders every frame. Returns -1 on failure.*/
+static int renderReplay(struct replayJob *Job, struct ThreadPool *Pool)
+{
+    const struct ReplayOptions *options = Job->Options;
+    SDL_Surface *surface = SDL_CreateSurface(options->Width, options->Height, SDL_PIXELFORMAT_XRGB8888);
+    SDL_Renderer *renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    struct DiscAtlas atlas;
+    struct FrameArena arena;
+    struct ObjectList bodies;
+    struct SceneRenderer scene;
+    SDL_zero(atlas);
+    SDL_zero(arena);
+    SDL_zero(bodies);
+
+    Job->Surface = surface;
+    Job->BatchCapacity = Pool->NumThreads;
+    Job->Batch = SDL_calloc((size_t)Job->BatchCapacity, sizeof(struct renderedFrame));
+    Job->Scratch = SDL_calloc((size_t)Pool->NumThreads, sizeof(Uint8 *));
+    Job->ScratchSize = SDL_calloc((size_t)Pool->NumThreads, sizeof(size_t));
+    int ready = renderer != NULL && Job->Batch != NULL && Job->Scratch != NULL && Job->ScratchSize != NULL;
+    for (int i = 0; ready && i < Job->BatchCapacity; ++i)
+    {
+        Job->Batch[i].Pixels = SDL_malloc((size_t)surface->pitch * surface->h);
+        ready = Job->Batch[i].Pixels != NULL;
+    }
+
+    int result = -1;
+    if (ready && InitFrameArena(&arena, FRAME_ARENA_SIZE) == 0)
+    {
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        if (CreateDiscAtlas(renderer, &atlas) != 0 && options->Mode == BODY_RENDER_SPRITE)
+        {
+            SDL_Log("Couldn't create disc sprites, drawing circles: %s", SDL_GetError());
+        }
+        InitSceneRenderer(&scene, &atlas);
+        scene.Mode = options->Mode == BODY_RENDER_SPRITE && atlas.Texture == NULL ? BODY_RENDER_GEOMETRY : options->Mode;
+        scene.TrailLength = options->TrailLength;
+
+        result = renderFrames(Job, Pool, renderer, &scene, &arena, &bodies);
+        ClearSceneRenderer(&scene);
+    }
+    if (result != 0)
+    {
+        SDL_Log("Couldn't render frames: %s", SDL_GetError());
+    }
+
+    for (int i = 0; Job->Batch != NULL && i < Job->BatchCapacity; ++i)
+    {
+        SDL_free(Job->Batch[i].Pixels);
+    }
+    for (int i = 0; Job->Scratch != NULL && i < Pool->NumThreads; ++i)
+    {
+        SDL_free(Job->Scratch[i]);
+    }
+    SDL_free(Job->Batch);
+    SDL_free(Job->Scratch);
+    SDL_free(Job->ScratchSize);
+    ClearObjects(&bodies);
+    DestroyFrameArena(&arena);
+    DestroyDiscAtlas(&atlas);
+    if (renderer != NULL)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
+    SDL_DestroySurface(surface);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    struct ReplayOptions options;
+    if (parseReplayOptions(argc, argv, &options) != 0)
+    {
+        return 1;
+    }
+
+    struct replayJob job;
+    SDL_zero(job);
+    job.Options = &options;
+    const char *extension = SDL_strrchr(options.OutputPath, '.');
+    if (extension == NULL || (SDL_strcasecmp(extension, ".ppm") != 0 && SDL_strcasecmp(extension, ".bmp") != 0))
+    {
+        SDL_Log("Output must be name.ppm or name.bmp, not %s", options.OutputPath);
+        return 1;
+    }
+    job.Bitmap = SDL_strcasecmp(extension, ".bmp") == 0;
+    job.Extension = extension;
+
+    struct Trajectory trajectory;
+    if (OpenTrajectory(&trajectory, options.TrajectoryFile) != 0)
+    {
+        SDL_Log("Couldn't open trajectory: %s", SDL_GetError());
+        return 1;
+    }
+    job.Trajectory = &trajectory;
+
+    struct CameraPath cameraPath;
+    SDL_zero(cameraPath);
+    if (options.CameraPathFile != NULL && LoadCameraPath(&cameraPath, options.CameraPathFile) != 0)
+    {
+        SDL_Log("Couldn't load camera path: %s", SDL_GetError());
+        CloseTrajectory(&trajectory);
+        return 1;
+    }
+    job.CameraPath = &cameraPath;
+
+    struct TrajectoryCursor first;
+    SDL_zero(first);
+    if (SeekTrajectory(&trajectory, &first, FindTrajectoryFrame(&trajectory, options.StartTime)) != 0)
+    {
+        SDL_Log("Couldn't read trajectory: %s", SDL_GetError());
+        ClearTrajectoryCursor(&first);
+        ClearCameraPath(&cameraPath);
+        CloseTrajectory(&trajectory);
+        return 1;
+    }
+    job.Camera = fitCamera(&options, &first);
+    ClearTrajectoryCursor(&first);
+
+    double endTime = trajectory.Index[trajectory.NumFrames - 1].Time;
+    if (options.EndTime >= 0.0)
+    {
+        endTime = SDL_min(endTime, options.EndTime);
+    }
+    if (endTime < options.StartTime)
+    {
+        SDL_Log("Nothing to render, the recording ends at %.3f s", trajectory.Index[trajectory.NumFrames - 1].Time);
+        ClearCameraPath(&cameraPath);
+        CloseTrajectory(&trajectory);
+        return 1;
+    }
+    job.NumFrames = (int)((endTime - options.StartTime) * options.FramesPerSecond / options.Speed) + 1;
+
+    job.Prefix = SDL_strndup(options.OutputPath, extension - options.OutputPath);
+    struct ThreadPool pool;
+    if (job.Prefix == NULL || CreateThreadPool(&pool, options.Threads) != 0)
+    {
+        SDL_Log("Couldn't start rendering threads.");
+        SDL_free(job.Prefix);
+        ClearCameraPath(&cameraPath);
+        CloseTrajectory(&trajectory);
+        return 1;
+    }
+
+    InitCircleTables();
+    SDL_Log("Rendering %d frames of %dx%d from %d recorded frames, written on %d threads", job.NumFrames, options.Width, options.Height,
+            trajectory.NumFrames, pool.NumThreads);
+
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    int rendered = renderReplay(&job, &pool);
+    double seconds = (SDL_GetPerformanceCounter() - startTime) / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("Rendered %d frames in %.2f s (%.1f frames per second)", job.NumFrames, seconds, job.NumFrames / SDL_max(seconds, 1e-6));
+
+    int failed = rendered != 0 || SDL_GetAtomicInt(&job.Failed) != 0;
+    DestroyThreadPool(&pool);
+    SDL_free(job.Prefix);
+    ClearCameraPath(&cameraPath);
+    CloseTrajectory(&trajectory);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,477 @@
+#include "scenario.h"
+
+#define PI 3.14159265f
+
+/* Files smaller than this are parsed on the calling thread, larger ones in this many chunks per pool thread*/
+#define PARALLEL_PARSE_BYTES (1024 * 1024)
+#define CHUNKS_PER_THREAD 4
+
+/* One slice of the file, cut at line starts for text and at records for binary*/
+struct parseChunk
+{
+    const char *Begin;
+    const char *End;
+
+    /* Bodies in the chunk, counted by the first pass, and index of its first body in the file*/
+    int NumBodies;
+    int First;
+
+    /* Where parsing stopped and why, NULL when the chunk is valid*/
+    const char *ErrorAt;
+    const char *Error;
+};
+
+struct parseJob
+{
+    struct parseChunk *Chunks;
+    struct Object *Bodies;
+    struct trailSample *Trails;
+};
+
+static int isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/* This function skips to the start of the next line*/
+static const char *nextLine(const char *p, const char *End)
+{
+    while (p < End && *p != '\n')
+    {
+        ++p;
+    }
+    return p < End ? p + 1 : End;
+}
+
+/* This function tells whether the line at p holds a body rather than nothing or a comment*/
+static int isBodyLine(const char *p, const char *End)
+{
+    while (p < End && isBlank(*p))
+    {
+        ++p;
+    }
+    return p < End && *p != '\n' && *p != '#';
+}
+
+/* This function parses a decimal number in place, faster than strtod since it ignores locales and hex.
+   Returns the character after it, or NULL when there is no number at p. */
+static const char *parseNumber(const char *p, const char *End, float *Value)
+{
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    while (p < End && isBlank(*p))
+    {
+        ++p;
+    }
+
+    int negative = 0;
+    if (p < End && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    /* Digits past the 18th do not fit the mantissa, they only move the exponent*/
+    Uint64 mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    for (; p < End && isDigit(*p); ++p, ++digits)
+    {
+        if (mantissa < 100000000000000000ull)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+    if (p < End && *p == '.')
+    {
+        for (++p; p < End && isDigit(*p); ++p, ++digits)
+        {
+            if (mantissa < 100000000000000000ull)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                --exponent;
+            }
+        }
+    }
+    if (digits == 0)
+    {
+        return NULL;
+    }
+
+    if (p < End && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        int negativeExponent = 0;
+        if (q < End && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = *q == '-';
+            ++q;
+        }
+        if (q < End && isDigit(*q))
+        {
+            int value = 0;
+            for (; q < End && isDigit(*q); ++q)
+            {
+                value = SDL_min(value * 10 + (*q - '0'), 1000);
+            }
+            exponent += negativeExponent ? -value : value;
+            p = q;
+        }
+    }
+
+    double value = (double)mantissa;
+    if (exponent != 0)
+    {
+        int magnitude = SDL_abs(exponent);
+        double scale = magnitude < (int)SDL_arraysize(powers) ? powers[magnitude] : SDL_pow(10.0, magnitude);
+        value = exponent < 0 ? value / scale : value * scale;
+    }
+    *Value = (float)(negative ? -value : value);
+    return p;
+}
+
+/* This function sets up a body from its fields, trail samples go to its share of the bulk storage*/
+static void initBody(struct Object *Body, const float *Fields, struct trailSample *Trail)
+{
+    Body->x = Fields[0];
+    Body->y = Fields[1];
+    Body->dx = Fields[2];
+    Body->dy = Fields[3];
+    Body->size = Fields[4];
+    /* Same density as bodies spawned with M when the file leaves the mass out*/
+    Body->mass = Fields[5] > 0.0f ? Fields[5] : Body->size * Body->size * PI * BODY_DENSITY;
+
+    initCirBufferWithStorage(&Body->trailBuffer, NUMBER_OF_TRAIL_PARTICLES, Trail);
+    resetTrailSampler(&Body->trailSampler);
+}
+
+static void countTextChunk(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct parseJob *job = UserData;
+    struct parseChunk *chunk = &job->Chunks[JobIndex];
+
+    int bodies = 0;
+    for (const char *p = chunk->Begin; p < chunk->End; p = nextLine(p, chunk->End))
+    {
+        bodies += isBodyLine(p, chunk->End);
+    }
+    chunk->NumBodies = bodies;
+}
+
+static void parseTextChunk(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct parseJob *job = UserData;
+    struct parseChunk *chunk = &job->Chunks[JobIndex];
+    const char *end = chunk->End;
+
+    int body = chunk->First;
+    for (const char *p = chunk->Begin; p < end; p = nextLine(p, end))
+    {
+        if (!isBodyLine(p, end))
+        {
+            continue;
+        }
+
+        float fields[SCENARIO_FIELDS] = {0};
+        int numFields = 0;
+        for (;;)
+        {
+            const char *next = parseNumber(p, end, &fields[numFields]);
+            if (next == NULL)
+            {
+                chunk->ErrorAt = p;
+                chunk->Error = "expected a number";
+                return;
+            }
+            p = next;
+            ++numFields;
+
+            while (p < end && isBlank(*p))
+            {
+                ++p;
+            }
+            if (p == end || *p == '\n')
+            {
+                break;
+            }
+            if (*p != ',')
+            {
+                chunk->ErrorAt = p;
+                chunk->Error = "expected a comma";
+                return;
+            }
+            if (numFields == SCENARIO_FIELDS)
+            {
+                chunk->ErrorAt = p;
+                chunk->Error = "too many fields";
+                return;
+            }
+            ++p;
+        }
+
+        if (numFields < SCENARIO_FIELDS - 1)
+        {
+            chunk->ErrorAt = p;
+            chunk->Error = "expected x, y, dx, dy, radius and an optional mass";
+            return;
+        }
+        if (!(fields[4] > 0.0f))
+        {
+            chunk->ErrorAt = p;
+            chunk->Error = "radius must be positive";
+            return;
+        }
+
+        initBody(&job->Bodies[body], fields, &job->Trails[(size_t)body * NUMBER_OF_TRAIL_PARTICLES]);
+        ++body;
+    }
+}
+
+static void parseBinaryChunk(void *UserData, int JobIndex, int ThreadIndex)
+{
+    struct parseJob *job = UserData;
+    struct parseChunk *chunk = &job->Chunks[JobIndex];
+
+    const char *record = chunk->Begin;
+    for (int i = 0; i < chunk->NumBodies; ++i, record += SCENARIO_FIELDS * sizeof(float))
+    {
+        float fields[SCENARIO_FIELDS];
+        for (int field = 0; field < SCENARIO_FIELDS; ++field)
+        {
+            Uint32 bits;
+            SDL_memcpy(&bits, record + field * sizeof(float), sizeof(bits));
+            bits = SDL_Swap32LE(bits);
+            SDL_memcpy(&fields[field], &bits, sizeof(bits));
+        }
+        if (!(fields[4] > 0.0f))
+        {
+            chunk->ErrorAt = record;
+            chunk->Error = "radius must be positive";
+            return;
+        }
+
+        int body = chunk->First + i;
+        initBody(&job->Bodies[body], fields, &job->Trails[(size_t)body * NUMBER_OF_TRAIL_PARTICLES]);
+    }
+}
+
+/* This function runs a pass over every chunk, across the pool when there is one*/
+static void runPass(struct ThreadPool *Pool, const char *Name, ParallelJob Job, struct parseJob *Data, int NumChunks)
+{
+    if (Pool != NULL && NumChunks > 1)
+    {
+        RunParallel(Pool, Name, Job, Data, NumChunks);
+        return;
+    }
+    for (int i = 0; i < NumChunks; ++i)
+    {
+        Job(Data, i, 0);
+    }
+}
+
+/* This function cuts a text file into chunks that start at line starts. Returns the number of chunks.*/
+static int splitText(const char *Begin, const char *End, struct parseChunk *Chunks, int MaxChunks)
+{
+    int numChunks = 0;
+    const char *p = Begin;
+    while (p < End && numChunks < MaxChunks)
+    {
+        const char *cut = numChunks == MaxChunks - 1 ? End : p + (End - p) / (MaxChunks - numChunks);
+        /* Finish the line the cut fell in*/
+        cut = cut > p ? nextLine(cut - 1, End) : nextLine(p, End);
+
+        SDL_zero(Chunks[numChunks]);
+        Chunks[numChunks].Begin = p;
+        Chunks[numChunks].End = cut;
+        ++numChunks;
+        p = cut;
+    }
+    return numChunks;
+}
+
+/* This function returns the line number of a position, for error messages*/
+static int lineOf(const char *Begin, const char *At)
+{
+    int line = 1;
+    for (const char *p = Begin; p < At; ++p)
+    {
+        line += *p == '\n';
+    }
+    return line;
+}
+
+int ParseScenario(struct ObjectList *Objects, struct ThreadPool *Pool, const char *File, const char *Data, size_t Size)
+{
+    const char *begin = Data;
+    const char *end = Data + Size;
+    int binary = Size >= SCENARIO_HEADER_SIZE && SDL_memcmp(Data, SCENARIO_MAGIC, 4) == 0;
+
+    int maxChunks = 1;
+    if (Pool != NULL && Size >= PARALLEL_PARSE_BYTES)
+    {
+        maxChunks = Pool->NumThreads * CHUNKS_PER_THREAD;
+    }
+    struct parseChunk *chunks = SDL_malloc(maxChunks * sizeof(struct parseChunk));
+    if (chunks == NULL)
+    {
+        return -1;
+    }
+
+    struct parseJob job = {chunks, NULL, NULL};
+    int numChunks = 0;
+    int numBodies = 0;
+    const char *error = NULL;
+
+    if (binary)
+    {
+        Uint32 version;
+        Uint64 count;
+        SDL_memcpy(&version, Data + 4, sizeof(version));
+        SDL_memcpy(&count, Data + 8, sizeof(count));
+        version = SDL_Swap32LE(version);
+        count = SDL_Swap64LE(count);
+
+        const size_t recordSize = SCENARIO_FIELDS * sizeof(float);
+        if (version != SCENARIO_VERSION)
+        {
+            error = "unsupported version";
+        }
+        else if (count > (Uint64)SDL_MAX_SINT32 || count > (Size - SCENARIO_HEADER_SIZE) / recordSize)
+        {
+            error = "body count does not match the file size";
+        }
+        else
+        {
+            numBodies = (int)count;
+            int perChunk = (numBodies + maxChunks - 1) / maxChunks;
+            for (int first = 0; first < numBodies; first += perChunk)
+            {
+                struct parseChunk *chunk = &chunks[numChunks++];
+                SDL_zerop(chunk);
+                chunk->Begin = Data + SCENARIO_HEADER_SIZE + first * recordSize;
+                chunk->NumBodies = SDL_min(perChunk, numBodies - first);
+                chunk->First = first;
+            }
+        }
+    }
+    else
+    {
+        /* A first line that does not start like a number is a header*/
+        const char *first = begin;
+        while (first < end && !isBodyLine(first, end))
+        {
+            first = nextLine(first, end);
+        }
+        while (first < end && isBlank(*first))
+        {
+            ++first;
+        }
+        if (first < end && !isDigit(*first) && *first != '-' && *first != '+' && *first != '.')
+        {
+            begin = nextLine(first, end);
+        }
+
+        numChunks = splitText(begin, end, chunks, maxChunks);
+        runPass(Pool, "scenario count", countTextChunk, &job, numChunks);
+        for (int i = 0; i < numChunks; ++i)
+        {
+            chunks[i].First = numBodies;
+            if (chunks[i].NumBodies > SDL_MAX_SINT32 - numBodies)
+            {
+                error = "too many bodies";
+                break;
+            }
+            numBodies += chunks[i].NumBodies;
+        }
+    }
+
+    /* Bodies are written straight into the list, past its end until the whole file is known to be valid*/
+    if (error != NULL)
+    {
+        SDL_SetError("%s: %s", File, error);
+    }
+    else if (numBodies > 0)
+    {
+        job.Trails = SDL_malloc((size_t)numBodies * NUMBER_OF_TRAIL_PARTICLES * sizeof(struct trailSample));
+        if (job.Trails == NULL || ReserveObjects(Objects, numBodies) != 0)
+        {
+            SDL_OutOfMemory();
+            error = "out of memory";
+        }
+        else
+        {
+            job.Bodies = &Objects->Data[Objects->NumItems];
+            runPass(Pool, "scenario parse", binary ? parseBinaryChunk : parseTextChunk, &job, numChunks);
+
+            for (int i = 0; i < numChunks && error == NULL; ++i)
+            {
+                struct parseChunk *chunk = &chunks[i];
+                if (chunk->Error == NULL)
+                {
+                    continue;
+                }
+                error = chunk->Error;
+                if (binary)
+                {
+                    int body = (int)((chunk->ErrorAt - Data - SCENARIO_HEADER_SIZE) / (SCENARIO_FIELDS * sizeof(float)));
+                    SDL_SetError("%s: body %d: %s", File, body, error);
+                }
+                else
+                {
+                    SDL_SetError("%s:%d: %s", File, lineOf(Data, chunk->ErrorAt), error);
+                }
+            }
+        }
+
+        if (error == NULL && AdoptTrailStorage(Objects, job.Trails) != 0)
+        {
+            SDL_OutOfMemory();
+            error = "out of memory";
+        }
+        if (error != NULL)
+        {
+            SDL_free(job.Trails);
+        }
+    }
+
+    SDL_free(chunks);
+    if (error != NULL)
+    {
+        return -1;
+    }
+
+    Objects->NumItems += numBodies;
+    return 0;
+}
+
+int LoadScenario(struct ObjectList *Objects, struct ThreadPool *Pool, const char *File)
+{
+    Uint64 startTime = SDL_GetPerformanceCounter();
+
+    size_t size;
+    char *text = SDL_LoadFile(File, &size);
+    if (text == NULL)
+    {
+        return -1;
+    }
+    int numBodies = Objects->NumItems;
+    int result = ParseScenario(Objects, Pool, File, text, size);
+    SDL_free(text);
+    if (result != 0)
+    {
+        return -1;
+    }
+
+    SDL_Log("Loaded %d bodies from %s in %.2f s", Objects->NumItems - numBodies, File, (SDL_GetPerformanceCounter() - startTime) / (double)SDL_GetPerformanceFrequency());
+    return 0;
+}
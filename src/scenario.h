@@ -0,0 +1,26 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+#include "threadPool.h"
+
+/* Binary scenario files start with this tag, a little-endian Uint32 version and a Uint64 body count,
+   followed by one record of SCENARIO_FIELDS little-endian floats per body. */
+#define SCENARIO_MAGIC "GMSB"
+#define SCENARIO_VERSION 1
+#define SCENARIO_HEADER_SIZE 16
+
+/* Fields of a body, in file order: x, y, dx, dy, radius, mass.
+   Text files hold one comma separated body per line, may leave the mass out (or 0) to derive it from the radius like spawned bodies,
+   and may start with a header line. Blank lines and lines starting with # are skipped. */
+#define SCENARIO_FIELDS 6
+
+/* This function appends the bodies of a text or binary scenario file to Objects, parsing large files across Pool (may be NULL).
+   Nothing is appended when the file is malformed. Returns -1 and sets the SDL error on failure. */
+int LoadScenario(struct ObjectList *Objects, struct ThreadPool *Pool, const char *File);
+/* This function does the same for a file already in memory. File only names it in errors.*/
+int ParseScenario(struct ObjectList *Objects, struct ThreadPool *Pool, const char *File, const char *Data, size_t Size);
+
+#endif
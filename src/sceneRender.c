@@ -0,0 +1,185 @@
+#include "sceneRender.h"
+
+#include "circle.h"
+
+#define PI 3.14159265f
+
+void InitSceneRenderer(struct SceneRenderer *Scene, const struct DiscAtlas *Atlas)
+{
+    SDL_zerop(Scene);
+    Scene->Mode = BODY_RENDER_AUTO;
+    Scene->PointRadius = 1.0f;
+    Scene->SpriteRadius = 12.0f;
+    Scene->TrailSpacing = 2.0f;
+    Scene->TrailLength = NUMBER_OF_TRAIL_PARTICLES;
+    Scene->TrailColor = (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f};
+    Scene->Atlas = Atlas;
+}
+
+void BindSceneRenderer(struct SceneRenderer *Scene, struct FrameArena *Arena)
+{
+    BindVertexBatch(&Scene->TrailBatch, Arena);
+    BindVertexBatch(&Scene->BodyBatch, Arena);
+    BindVertexBatch(&Scene->SpriteBatch, Arena);
+    BindPointBatch(&Scene->PointBatch, Arena);
+}
+
+/* This function appends one trail segment as a quad, fading from the alpha of its start to the alpha of its end*/
+static void addTrailSegment(struct SceneRenderer *Scene, float x0, float y0, float alpha0, float x1, float y1, float alpha1, float halfWidth)
+{
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float length = SDL_sqrtf(dx * dx + dy * dy);
+
+    /* Normal of the segment, a degenerate segment becomes an axis aligned square*/
+    float nx = 0.0f;
+    float ny = halfWidth;
+    if (length > 0.001f)
+    {
+        nx = -dy / length * halfWidth;
+        ny = dx / length * halfWidth;
+    }
+
+    SDL_FColor color = Scene->TrailColor;
+    SDL_FColor startColor = {color.r, color.g, color.b, alpha0};
+    SDL_FColor endColor = {color.r, color.g, color.b, alpha1};
+    SDL_Vertex corners[4] = {
+        {{x0 + nx, y0 + ny}, startColor, {0.0f, 0.0f}},
+        {{x1 + nx, y1 + ny}, endColor, {0.0f, 0.0f}},
+        {{x1 - nx, y1 - ny}, endColor, {0.0f, 0.0f}},
+        {{x0 - nx, y0 - ny}, startColor, {0.0f, 0.0f}}};
+
+    AddQuadToBatch(&Scene->TrailBatch, corners);
+}
+
+/* Nothing is drawn here, the whole batch goes out in one SDL_RenderGeometry call. */
+void AddTrailToScene(struct SceneRenderer *Scene, struct Object *Body)
+{
+    struct cirBuffer *trailBuffer = &Body->trailBuffer;
+    const struct View *view = &Scene->View;
+    /* Only the newest TrailLength samples are drawn, and they fade over that length*/
+    int length = SDL_min(Scene->TrailLength, trailBuffer->capacity);
+    int count = SDL_min(trailBuffer->count, length);
+    if (count == 0)
+    {
+        return;
+    }
+
+    int start = (trailBuffer->writePointer - count + trailBuffer->capacity) % trailBuffer->capacity;
+    trailBuffer->readPointer = start;
+
+    struct SDL_FPoint previous = readCirBuffer(trailBuffer);
+    float PrevRelativeX = (view->RootX - previous.x) * view->Zoom;
+    float PrevRelativeY = (view->RootY - previous.y) * view->Zoom;
+    float PrevAlpha = (float)(length - count) / (float)length;
+
+    float halfWidth = TRAIL_PARTICLE_SIZE * (view->Zoom + 0.5f) * 0.5f;
+
+    for (int i = 1; i <= count; ++i)
+    {
+        /* The last segment joins the newest sample to the current position*/
+        struct SDL_FPoint trail = i < count ? readCirBuffer(trailBuffer) : (struct SDL_FPoint){Body->x, Body->y};
+
+        /* Calculate relative coordinates and apply zoom*/
+        float TrailRelativeX = (view->RootX - trail.x) * view->Zoom;
+        float TrailRelativeY = (view->RootY - trail.y) * view->Zoom;
+
+        /* Decimate: skip samples that would add less than TrailSpacing on screen, but always reach the body*/
+        float stepX = TrailRelativeX - PrevRelativeX;
+        float stepY = TrailRelativeY - PrevRelativeY;
+        if (i < count && stepX * stepX + stepY * stepY < Scene->TrailSpacing * Scene->TrailSpacing)
+        {
+            continue;
+        }
+
+        /* Older segments fade out, the newest is fully opaque*/
+        int age = length - count + i;
+        float alpha = (float)SDL_min(age, length) / (float)length;
+
+        if (!(
+                SDL_max(TrailRelativeX, PrevRelativeX) + halfWidth < 0 || SDL_min(TrailRelativeX, PrevRelativeX) - halfWidth > view->Width ||
+                SDL_max(TrailRelativeY, PrevRelativeY) + halfWidth < 0 || SDL_min(TrailRelativeY, PrevRelativeY) - halfWidth > view->Height))
+        {
+            addTrailSegment(Scene, PrevRelativeX, PrevRelativeY, PrevAlpha, TrailRelativeX, TrailRelativeY, alpha, halfWidth);
+        }
+
+        PrevRelativeX = TrailRelativeX;
+        PrevRelativeY = TrailRelativeY;
+        PrevAlpha = alpha;
+    }
+}
+
+void AddBodyToScene(struct SceneRenderer *Scene, const struct Object *Body)
+{
+    const struct View *view = &Scene->View;
+
+    /* Calculate relative coordinates and apply zoom*/
+    float ObjectRelativeX = (view->RootX - Body->x) * view->Zoom;
+    float ObjectRelativeY = (view->RootY - Body->y) * view->Zoom;
+    float ObjectSize = Body->size * view->Zoom;
+
+    /* Check if object is out-of-bound, if yes then don't render*/
+    if (ObjectRelativeX + ObjectSize < 0 || ObjectRelativeX - ObjectSize > view->Width ||
+        ObjectRelativeY + ObjectSize < 0 || ObjectRelativeY - ObjectSize > view->Height)
+    {
+        return;
+    }
+
+    enum BodyRenderMode mode = Scene->Mode;
+    if (mode == BODY_RENDER_AUTO)
+    {
+        if (ObjectSize < Scene->PointRadius)
+        {
+            AddPointToBatch(&Scene->PointBatch, ObjectRelativeX, ObjectRelativeY);
+            return;
+        }
+        mode = ObjectSize < Scene->SpriteRadius && Scene->Atlas->Texture != NULL ? BODY_RENDER_SPRITE : BODY_RENDER_GEOMETRY;
+    }
+
+    if (mode == BODY_RENDER_SPRITE)
+    {
+        AddDiscSpriteToBatch(&Scene->SpriteBatch, Scene->Atlas, ObjectRelativeX, ObjectRelativeY, ObjectSize, (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f});
+    }
+    else
+    {
+        AddCircleToBatch(&Scene->BodyBatch, ObjectRelativeX, ObjectRelativeY, ObjectSize, (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f});
+    }
+}
+
+void AddAggregateToScene(struct SceneRenderer *Scene, float X, float Y, float Mass)
+{
+    const struct View *view = &Scene->View;
+    float ObjectRelativeX = (view->RootX - X) * view->Zoom;
+    float ObjectRelativeY = (view->RootY - Y) * view->Zoom;
+    float ObjectSize = SDL_sqrtf(Mass / (PI * BODY_DENSITY)) * view->Zoom;
+
+    if (ObjectSize < Scene->PointRadius || Scene->Atlas->Texture == NULL)
+    {
+        AddPointToBatch(&Scene->PointBatch, ObjectRelativeX, ObjectRelativeY);
+    }
+    else
+    {
+        AddDiscSpriteToBatch(&Scene->SpriteBatch, Scene->Atlas, ObjectRelativeX, ObjectRelativeY, ObjectSize, (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f});
+    }
+}
+
+void FlushSceneTrails(SDL_Renderer *Renderer, struct SceneRenderer *Scene)
+{
+    FlushVertexBatch(Renderer, &Scene->TrailBatch, NULL);
+}
+
+/* Points take the current draw color, bodies are white like their vertices*/
+void FlushSceneBodies(SDL_Renderer *Renderer, struct SceneRenderer *Scene)
+{
+    FlushPointBatch(Renderer, &Scene->PointBatch);
+    FlushVertexBatch(Renderer, &Scene->SpriteBatch, Scene->Atlas->Texture);
+    FlushVertexBatch(Renderer, &Scene->BodyBatch, NULL);
+}
+
+void ClearSceneRenderer(struct SceneRenderer *Scene)
+{
+    ClearVertexBatch(&Scene->TrailBatch);
+    ClearVertexBatch(&Scene->BodyBatch);
+    ClearVertexBatch(&Scene->SpriteBatch);
+    ClearPointBatch(&Scene->PointBatch);
+}
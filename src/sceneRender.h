@@ -0,0 +1,63 @@
+#ifndef SCENERENDER_H
+#define SCENERENDER_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+#include "vertexBatch.h"
+#include "discSprite.h"
+#include "view.h"
+
+/* How bodies are drawn, switched with R */
+enum BodyRenderMode
+{
+    BODY_RENDER_AUTO,     /* picks points, sprites or circles per body from its on-screen radius */
+    BODY_RENDER_GEOMETRY, /* filled triangle fans, detail grows with on-screen size */
+    BODY_RENDER_SPRITE,   /* one textured quad per body from the pre-rendered disc atlas */
+    BODY_RENDER_DENSITY,  /* mass splatted into a density image, cost follows pixels rather than bodies */
+    BODY_RENDER_MODE_COUNT
+};
+
+/* Turns bodies and their trails into batched geometry for one camera and one renderer.
+   The simulation keeps one for the window, the replay tool one per worker thread. */
+struct SceneRenderer
+{
+    struct View View;
+    enum BodyRenderMode Mode;
+
+    /* Level of detail thresholds, in on-screen pixels.
+       Bodies below PointRadius are single points, below SpriteRadius sprites, and full circles above. */
+    float PointRadius;
+    float SpriteRadius;
+    /* Trail samples closer than this on screen to the previous drawn one are skipped */
+    float TrailSpacing;
+    /* Newest trail samples drawn per body */
+    int TrailLength;
+    SDL_FColor TrailColor;
+
+    /* Sprites of the renderer the batches are flushed to, automatic mode falls back to circles while it has no texture */
+    const struct DiscAtlas *Atlas;
+
+    /* Trail quads, filled discs, disc sprites and single points, each submitted in one call */
+    struct VertexBatch TrailBatch;
+    struct VertexBatch BodyBatch;
+    struct VertexBatch SpriteBatch;
+    struct PointBatch PointBatch;
+};
+
+/* This function sets the default mode and level of detail, with sprites taken from Atlas.*/
+void InitSceneRenderer(struct SceneRenderer *Scene, const struct DiscAtlas *Atlas);
+/* This function makes every batch take its storage from Arena for the current frame. Call it after every reset of the arena.*/
+void BindSceneRenderer(struct SceneRenderer *Scene, struct FrameArena *Arena);
+/* This function adds the trail of a body, as segments between consecutive samples ending at the body itself.*/
+void AddTrailToScene(struct SceneRenderer *Scene, struct Object *Body);
+/* This function adds a body as a point, sprite or circle, or nothing when it is out of view.*/
+void AddBodyToScene(struct SceneRenderer *Scene, const struct Object *Body);
+/* This function adds a cluster as one glyph at its centre of mass, as big as a single body of the same mass.*/
+void AddAggregateToScene(struct SceneRenderer *Scene, float X, float Y, float Mass);
+/* These functions submit the collected trails, and the collected bodies, and empty their batches.*/
+void FlushSceneTrails(SDL_Renderer *Renderer, struct SceneRenderer *Scene);
+void FlushSceneBodies(SDL_Renderer *Renderer, struct SceneRenderer *Scene);
+void ClearSceneRenderer(struct SceneRenderer *Scene);
+
+#endif
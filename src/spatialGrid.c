@@ -0,0 +1,233 @@
+#include "spatialGrid.h"
+#include "frameArena.h"
+
+int AddIndex(struct IndexList *WishedList, int Index)
+{
+    if (GrowArray(NULL, (void **)&WishedList->Data, &WishedList->Capacity, WishedList->NumItems, WishedList->NumItems + 1, sizeof(int)) != 0)
+    {
+        return -1;
+    }
+    WishedList->Data[WishedList->NumItems++] = Index;
+    return 0;
+}
+
+int AppendIndex(struct IndexList *WishedList, int Index)
+{
+    SDL_assert(WishedList->NumItems < WishedList->Capacity);
+    if (WishedList->NumItems >= WishedList->Capacity)
+    {
+        return -1;
+    }
+    WishedList->Data[WishedList->NumItems++] = Index;
+    return 0;
+}
+
+void ClearIndexList(struct IndexList *WishedList)
+{
+    SDL_free(WishedList->Data);
+    WishedList->Data = NULL;
+    WishedList->NumItems = 0;
+    WishedList->Capacity = 0;
+}
+
+/* This function returns the world bounds of an object: its disc, its trail and the segment joining them*/
+static void objectBounds(const struct Object *obj, float *MinX, float *MinY, float *MaxX, float *MaxY)
+{
+    *MinX = obj->x - obj->size;
+    *MinY = obj->y - obj->size;
+    *MaxX = obj->x + obj->size;
+    *MaxY = obj->y + obj->size;
+
+    if (obj->trailBuffer.count > 0)
+    {
+        *MinX = SDL_min(*MinX, obj->trailBuffer.minX);
+        *MinY = SDL_min(*MinY, obj->trailBuffer.minY);
+        *MaxX = SDL_max(*MaxX, obj->trailBuffer.maxX);
+        *MaxY = SDL_max(*MaxY, obj->trailBuffer.maxY);
+    }
+}
+
+/* This function converts a world rectangle to an inclusive, clamped range of cells*/
+static void cellRange(const struct SpatialGrid *Grid, float MinX, float MinY, float MaxX, float MaxY, int *Col0, int *Row0, int *Col1, int *Row1)
+{
+    *Col0 = SDL_clamp((int)((MinX - Grid->OriginX) * Grid->InvCellSize), 0, Grid->Cols - 1);
+    *Row0 = SDL_clamp((int)((MinY - Grid->OriginY) * Grid->InvCellSize), 0, Grid->Rows - 1);
+    *Col1 = SDL_clamp((int)((MaxX - Grid->OriginX) * Grid->InvCellSize), 0, Grid->Cols - 1);
+    *Row1 = SDL_clamp((int)((MaxY - Grid->OriginY) * Grid->InvCellSize), 0, Grid->Rows - 1);
+}
+
+int BuildSpatialGrid(struct SpatialGrid *Grid, const struct ObjectList *Objects)
+{
+    int count = Objects->NumItems;
+    Grid->Oversized.NumItems = 0;
+
+    if (GrowArray(NULL, (void **)&Grid->Stamp, &Grid->StampCapacity, 0, SDL_max(count, 1), sizeof(Uint32)) != 0)
+    {
+        return -1;
+    }
+    SDL_memset(Grid->Stamp, 0, Grid->StampCapacity * sizeof(Uint32));
+    Grid->QueryId = 0;
+
+    /* Size the grid to the bounds of the whole scene, about one object per cell*/
+    float sceneMinX = 0.0f, sceneMinY = 0.0f, sceneMaxX = 1.0f, sceneMaxY = 1.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        float minX, minY, maxX, maxY;
+        objectBounds(&Objects->Data[i], &minX, &minY, &maxX, &maxY);
+        if (i == 0)
+        {
+            sceneMinX = minX, sceneMinY = minY, sceneMaxX = maxX, sceneMaxY = maxY;
+        }
+        sceneMinX = SDL_min(sceneMinX, minX);
+        sceneMinY = SDL_min(sceneMinY, minY);
+        sceneMaxX = SDL_max(sceneMaxX, maxX);
+        sceneMaxY = SDL_max(sceneMaxY, maxY);
+    }
+
+    int cellsPerAxis = SDL_clamp((int)SDL_sqrtf((float)count), 1, SPATIAL_GRID_MAX_CELLS);
+    float extent = SDL_max(SDL_max(sceneMaxX - sceneMinX, sceneMaxY - sceneMinY), 1.0f);
+    float cellSize = extent / cellsPerAxis;
+
+    Grid->OriginX = sceneMinX;
+    Grid->OriginY = sceneMinY;
+    Grid->InvCellSize = 1.0f / cellSize;
+    Grid->Cols = SDL_clamp((int)((sceneMaxX - sceneMinX) / cellSize) + 1, 1, SPATIAL_GRID_MAX_CELLS);
+    Grid->Rows = SDL_clamp((int)((sceneMaxY - sceneMinY) / cellSize) + 1, 1, SPATIAL_GRID_MAX_CELLS);
+
+    int numCells = Grid->Cols * Grid->Rows;
+    if (GrowArray(NULL, (void **)&Grid->CellStart, &Grid->CellCapacity, 0, numCells + 1, sizeof(int)) != 0)
+    {
+        return -1;
+    }
+    SDL_memset(Grid->CellStart, 0, (numCells + 1) * sizeof(int));
+
+    /* Count entries per cell, shifted by one so the prefix sum gives start offsets*/
+    for (int i = 0; i < count; ++i)
+    {
+        float minX, minY, maxX, maxY;
+        int col0, row0, col1, row1;
+        objectBounds(&Objects->Data[i], &minX, &minY, &maxX, &maxY);
+        cellRange(Grid, minX, minY, maxX, maxY, &col0, &row0, &col1, &row1);
+
+        if ((col1 - col0 + 1) * (row1 - row0 + 1) > SPATIAL_GRID_MAX_SPAN)
+        {
+            if (AddIndex(&Grid->Oversized, i) != 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+        for (int row = row0; row <= row1; ++row)
+        {
+            for (int col = col0; col <= col1; ++col)
+            {
+                ++Grid->CellStart[row * Grid->Cols + col + 1];
+            }
+        }
+    }
+
+    for (int cell = 0; cell < numCells; ++cell)
+    {
+        Grid->CellStart[cell + 1] += Grid->CellStart[cell];
+    }
+
+    if (GrowArray(NULL, (void **)&Grid->Entries, &Grid->EntryCapacity, 0, SDL_max(Grid->CellStart[numCells], 1), sizeof(int)) != 0)
+    {
+        return -1;
+    }
+
+    /* Fill, using the start offsets as write cursors and then shifting them back*/
+    for (int i = 0, oversized = 0; i < count; ++i)
+    {
+        if (oversized < Grid->Oversized.NumItems && Grid->Oversized.Data[oversized] == i)
+        {
+            ++oversized;
+            continue;
+        }
+
+        float minX, minY, maxX, maxY;
+        int col0, row0, col1, row1;
+        objectBounds(&Objects->Data[i], &minX, &minY, &maxX, &maxY);
+        cellRange(Grid, minX, minY, maxX, maxY, &col0, &row0, &col1, &row1);
+
+        for (int row = row0; row <= row1; ++row)
+        {
+            for (int col = col0; col <= col1; ++col)
+            {
+                Grid->Entries[Grid->CellStart[row * Grid->Cols + col]++] = i;
+            }
+        }
+    }
+    for (int cell = numCells; cell > 0; --cell)
+    {
+        Grid->CellStart[cell] = Grid->CellStart[cell - 1];
+    }
+    Grid->CellStart[0] = 0;
+    return 0;
+}
+
+int QuerySpatialGrid(struct SpatialGrid *Grid, float MinX, float MinY, float MaxX, float MaxY, struct IndexList *Result)
+{
+    Result->NumItems = 0;
+    if (Grid->CellStart == NULL)
+    {
+        return 0;
+    }
+
+    /* A new stamp value per query, wiping the stamps when it wraps around*/
+    if (++Grid->QueryId == 0)
+    {
+        SDL_memset(Grid->Stamp, 0, Grid->StampCapacity * sizeof(Uint32));
+        Grid->QueryId = 1;
+    }
+
+    for (int i = 0; i < Grid->Oversized.NumItems; ++i)
+    {
+        if (AppendIndex(Result, Grid->Oversized.Data[i]) != 0)
+        {
+            return -1;
+        }
+    }
+
+    /* Nothing to visit if the rectangle misses the grid entirely*/
+    if (MaxX < Grid->OriginX || MaxY < Grid->OriginY ||
+        MinX > Grid->OriginX + Grid->Cols / Grid->InvCellSize || MinY > Grid->OriginY + Grid->Rows / Grid->InvCellSize)
+    {
+        return 0;
+    }
+
+    int col0, row0, col1, row1;
+    cellRange(Grid, MinX, MinY, MaxX, MaxY, &col0, &row0, &col1, &row1);
+
+    for (int row = row0; row <= row1; ++row)
+    {
+        for (int col = col0; col <= col1; ++col)
+        {
+            int cell = row * Grid->Cols + col;
+            for (int e = Grid->CellStart[cell]; e < Grid->CellStart[cell + 1]; ++e)
+            {
+                int index = Grid->Entries[e];
+                if (Grid->Stamp[index] == Grid->QueryId)
+                {
+                    continue;
+                }
+                Grid->Stamp[index] = Grid->QueryId;
+
+                if (AppendIndex(Result, index) != 0)
+                {
+                    return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+void ClearSpatialGrid(struct SpatialGrid *Grid)
+{
+    SDL_free(Grid->CellStart);
+    SDL_free(Grid->Entries);
+    SDL_free(Grid->Stamp);
+    ClearIndexList(&Grid->Oversized);
+    SDL_zerop(Grid);
+}
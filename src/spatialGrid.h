@@ -0,0 +1,55 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include "objects.h"
+
+/* Largest number of cells per axis*/
+#define SPATIAL_GRID_MAX_CELLS 512
+/* Objects whose bounds cover more cells than this are kept in a separate list and tested one by one*/
+#define SPATIAL_GRID_MAX_SPAN 64
+
+/* A growable list of object indices*/
+struct IndexList
+{
+    int NumItems;
+    int Capacity;
+    int *Data;
+};
+
+/* Uniform grid over the bounds of every object (its disc plus its trail).
+   Cells are stored as ranges of one entry array, filled with a counting sort. */
+struct SpatialGrid
+{
+    float OriginX;
+    float OriginY;
+    float InvCellSize;
+    int Cols;
+    int Rows;
+
+    int CellCapacity;
+    int *CellStart; /* Cols * Rows + 1 offsets into Entries */
+
+    int EntryCapacity;
+    int *Entries;
+
+    struct IndexList Oversized;
+
+    /* Per object, the id of the last query that reported it, so objects spanning several cells are reported once */
+    int StampCapacity;
+    Uint32 *Stamp;
+    Uint32 QueryId;
+};
+
+/* This function rebuilds the grid from the current objects. Returns -1 if the allocation fails.*/
+int BuildSpatialGrid(struct SpatialGrid *Grid, const struct ObjectList *Objects);
+/* This function replaces the contents of Result with every object whose bounds overlap the rectangle.
+   Result is never grown, so its storage may come from an arena: it needs room for one index per object, or the query returns -1. */
+int QuerySpatialGrid(struct SpatialGrid *Grid, float MinX, float MinY, float MaxX, float MaxY, struct IndexList *Result);
+void ClearSpatialGrid(struct SpatialGrid *Grid);
+
+int AddIndex(struct IndexList *WishedList, int Index);
+/* This function appends without growing the list. Returns -1 if it is full.*/
+int AppendIndex(struct IndexList *WishedList, int Index);
+void ClearIndexList(struct IndexList *WishedList);
+
+#endif
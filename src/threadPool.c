@@ -0,0 +1,168 @@
+#include "threadPool.h"
+#include "traceRecorder.h"
+
+struct workerStart
+{
+    struct ThreadPool *Pool;
+    int ThreadIndex;
+};
+
+/* This function takes jobs until none are left*/
+static void drainJobs(struct ThreadPool *Pool, int ThreadIndex)
+{
+    for (;;)
+    {
+        int job = SDL_AddAtomicInt(&Pool->NextJob, 1);
+        if (job >= Pool->NumJobs)
+        {
+            return;
+        }
+        TraceBegin(Pool->Name);
+        Pool->Job(Pool->UserData, job, ThreadIndex);
+        TraceEnd(Pool->Name);
+    }
+}
+
+static int workerMain(void *Data)
+{
+    struct workerStart start = *(struct workerStart *)Data;
+    SDL_free(Data);
+    SetTraceThreadName("worker");
+
+    for (;;)
+    {
+        SDL_WaitSemaphore(start.Pool->WorkReady);
+        if (start.Pool->Quit)
+        {
+            return 0;
+        }
+        drainJobs(start.Pool, start.ThreadIndex);
+        SDL_SignalSemaphore(start.Pool->WorkDone);
+    }
+}
+
+int CreateThreadPool(struct ThreadPool *Pool, int NumThreads)
+{
+    SDL_zerop(Pool);
+    Pool->NumThreads = NumThreads > 0 ? NumThreads : SDL_GetNumLogicalCPUCores();
+    if (Pool->NumThreads < 1)
+    {
+        Pool->NumThreads = 1;
+    }
+
+    Pool->WorkReady = SDL_CreateSemaphore(0);
+    Pool->WorkDone = SDL_CreateSemaphore(0);
+    Pool->Threads = SDL_calloc(Pool->NumThreads, sizeof(SDL_Thread *));
+    Pool->Arenas = SDL_calloc(Pool->NumThreads, sizeof(struct FrameArena));
+    if (Pool->WorkReady == NULL || Pool->WorkDone == NULL || Pool->Threads == NULL || Pool->Arenas == NULL)
+    {
+        DestroyThreadPool(Pool);
+        return -1;
+    }
+
+    for (int i = 1; i < Pool->NumThreads; ++i)
+    {
+        struct workerStart *start = SDL_malloc(sizeof(struct workerStart));
+        if (start == NULL)
+        {
+            Pool->NumThreads = i;
+            break;
+        }
+        start->Pool = Pool;
+        start->ThreadIndex = i;
+
+        Pool->Threads[i] = SDL_CreateThread(workerMain, "worker", start);
+        if (Pool->Threads[i] == NULL)
+        {
+            /* Run with the workers we have rather than failing*/
+            SDL_free(start);
+            Pool->NumThreads = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < Pool->NumThreads; ++i)
+    {
+        if (InitFrameArena(&Pool->Arenas[i], WORKER_ARENA_SIZE) != 0)
+        {
+            DestroyThreadPool(Pool);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void RunParallel(struct ThreadPool *Pool, const char *Name, ParallelJob Job, void *UserData, int NumJobs)
+{
+    if (NumJobs <= 0)
+    {
+        return;
+    }
+
+    Pool->Job = Job;
+    Pool->Name = Name;
+    Pool->UserData = UserData;
+    Pool->NumJobs = NumJobs;
+    SDL_SetAtomicInt(&Pool->NextJob, 0);
+
+    /* A single job is not worth waking anybody up for*/
+    int helpers = SDL_min(Pool->NumThreads, NumJobs) - 1;
+    for (int i = 0; i < helpers; ++i)
+    {
+        SDL_SignalSemaphore(Pool->WorkReady);
+    }
+
+    drainJobs(Pool, 0);
+
+    for (int i = 0; i < helpers; ++i)
+    {
+        SDL_WaitSemaphore(Pool->WorkDone);
+    }
+}
+
+void ResetPoolArenas(struct ThreadPool *Pool)
+{
+    for (int i = 0; i < Pool->NumThreads; ++i)
+    {
+        ResetFrameArena(&Pool->Arenas[i]);
+    }
+}
+
+void DestroyThreadPool(struct ThreadPool *Pool)
+{
+    if (Pool->Threads != NULL)
+    {
+        Pool->Quit = 1;
+        for (int i = 1; i < Pool->NumThreads; ++i)
+        {
+            SDL_SignalSemaphore(Pool->WorkReady);
+        }
+        for (int i = 1; i < Pool->NumThreads; ++i)
+        {
+            SDL_WaitThread(Pool->Threads[i], NULL);
+        }
+        SDL_free(Pool->Threads);
+        Pool->Threads = NULL;
+    }
+    if (Pool->Arenas != NULL)
+    {
+        /* Arenas that were never initialised are all zero, which DestroyFrameArena accepts*/
+        for (int i = 0; i < Pool->NumThreads; ++i)
+        {
+            DestroyFrameArena(&Pool->Arenas[i]);
+        }
+        SDL_free(Pool->Arenas);
+        Pool->Arenas = NULL;
+    }
+    if (Pool->WorkReady != NULL)
+    {
+        SDL_DestroySemaphore(Pool->WorkReady);
+        Pool->WorkReady = NULL;
+    }
+    if (Pool->WorkDone != NULL)
+    {
+        SDL_DestroySemaphore(Pool->WorkDone);
+        Pool->WorkDone = NULL;
+    }
+    Pool->NumThreads = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <SDL3/SDL.h>
+
+#include "frameArena.h"
+
+/* Starting size of each thread's scratch arena*/
+#define WORKER_ARENA_SIZE (256 * 1024)
+
+/* A job receives its index and the index of the thread running it (0 is the calling thread).
+   The thread index is stable for the duration of a RunParallel call and can select per-thread scratch data. */
+typedef void (*ParallelJob)(void *UserData, int JobIndex, int ThreadIndex);
+
+/* A fixed set of worker threads that run parallel-for loops together with the calling thread*/
+struct ThreadPool
+{
+    int NumThreads; /* workers plus the calling thread */
+    SDL_Thread **Threads;
+
+    /* Per-frame scratch memory of each thread, indexed like the ThreadIndex given to jobs */
+    struct FrameArena *Arenas;
+
+    SDL_Semaphore *WorkReady;
+    SDL_Semaphore *WorkDone;
+
+    ParallelJob Job;
+    const char *Name;
+    void *UserData;
+    int NumJobs;
+    SDL_AtomicInt NextJob;
+
+    int Quit;
+};
+
+/* This function starts NumThreads - 1 workers, or one per logical core if NumThreads is 0. Returns -1 on failure.*/
+int CreateThreadPool(struct ThreadPool *Pool, int NumThreads);
+/* This function runs Job for every index in [0, NumJobs) across the pool and returns once all of them are done.
+   Name labels every job in the trace recorder. */
+void RunParallel(struct ThreadPool *Pool, const char *Name, ParallelJob Job, void *UserData, int NumJobs);
+/* This function resets the scratch arena of every thread. Call it between parallel runs, normally at the top of a frame.*/
+void ResetPoolArenas(struct ThreadPool *Pool);
+void DestroyThreadPool(struct ThreadPool *Pool);
+
+#endif
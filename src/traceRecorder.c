@@ -0,0 +1,176 @@
+#include "traceRecorder.h"
+
+struct traceEvent
+{
+    const char *Name;
+    Uint64 Ticks;
+    char Phase; /* 'B' or 'E' */
+};
+
+/* Written by its own thread only, so recording needs no lock.
+   Events form a ring: once it is full the newest event overwrites the oldest, so a long run keeps its last stretch. */
+struct threadTrace
+{
+    SDL_ThreadID ThreadId;
+    const char *Name;
+    /* Events recorded since the last flush, the ring holds the newest TRACE_EVENTS_PER_THREAD of them*/
+    SDL_AtomicInt Count;
+    int Dropped;
+    struct traceEvent *Events;
+};
+
+static struct threadTrace threads[TRACE_MAX_THREADS];
+static SDL_AtomicInt numThreads;
+static SDL_AtomicInt recording;
+/* Slot index + 1 of the calling thread*/
+static SDL_TLSID threadSlot;
+static Uint64 startTicks;
+
+void StartTraceRecorder(void)
+{
+    startTicks = SDL_GetPerformanceCounter();
+    SDL_SetAtomicInt(&recording, 1);
+}
+
+void StopTraceRecorder(void)
+{
+    SDL_SetAtomicInt(&recording, 0);
+    for (int i = 0; i < TRACE_MAX_THREADS; ++i)
+    {
+        SDL_free(threads[i].Events);
+        threads[i].Events = NULL;
+        SDL_SetAtomicInt(&threads[i].Count, 0);
+        threads[i].Dropped = 0;
+    }
+}
+
+bool IsTraceRecording(void)
+{
+    return SDL_GetAtomicInt(&recording) != 0;
+}
+
+/* This function returns the buffer of the calling thread, claiming a free one on first use*/
+static struct threadTrace *currentThread(void)
+{
+    intptr_t slot = (intptr_t)SDL_GetTLS(&threadSlot);
+    if (slot == 0)
+    {
+        slot = SDL_AddAtomicInt(&numThreads, 1) + 1;
+        SDL_SetTLS(&threadSlot, (void *)slot, NULL);
+        if (slot <= TRACE_MAX_THREADS)
+        {
+            threads[slot - 1].ThreadId = SDL_GetCurrentThreadID();
+        }
+    }
+    return slot <= TRACE_MAX_THREADS ? &threads[slot - 1] : NULL;
+}
+
+void SetTraceThreadName(const char *Name)
+{
+    struct threadTrace *thread = currentThread();
+    if (thread != NULL)
+    {
+        thread->Name = Name;
+    }
+}
+
+static void record(const char *Name, char Phase)
+{
+    if (!SDL_GetAtomicInt(&recording))
+    {
+        return;
+    }
+
+    struct threadTrace *thread = currentThread();
+    if (thread == NULL)
+    {
+        return;
+    }
+    if (thread->Events == NULL)
+    {
+        thread->Events = SDL_malloc(TRACE_EVENTS_PER_THREAD * sizeof(struct traceEvent));
+        if (thread->Events == NULL)
+        {
+            ++thread->Dropped;
+            return;
+        }
+    }
+
+    int count = SDL_GetAtomicInt(&thread->Count);
+    thread->Events[count % TRACE_EVENTS_PER_THREAD] = (struct traceEvent){Name, SDL_GetPerformanceCounter(), Phase};
+    /* Publish the event only once it is complete*/
+    SDL_SetAtomicInt(&thread->Count, count + 1);
+}
+
+void TraceBegin(const char *Name)
+{
+    record(Name, 'B');
+}
+
+void TraceEnd(const char *Name)
+{
+    record(Name, 'E');
+}
+
+int FlushTraceRecorder(const char *Path)
+{
+    if (!IsTraceRecording())
+    {
+        return 0;
+    }
+
+    SDL_IOStream *file = SDL_IOFromFile(Path, "w");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    double microsecondsPerTick = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    int usedThreads = SDL_min(SDL_GetAtomicInt(&numThreads), TRACE_MAX_THREADS);
+    const char *separator = "";
+
+    SDL_IOprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int t = 0; t < usedThreads; ++t)
+    {
+        struct threadTrace *thread = &threads[t];
+        int count = SDL_GetAtomicInt(&thread->Count);
+
+        if (thread->Name != NULL)
+        {
+            SDL_IOprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"args\":{\"name\":\"%s\"}}",
+                         separator, (Uint64)thread->ThreadId, thread->Name);
+            separator = ",\n";
+        }
+        /* After the ring wrapped, spans whose start was overwritten are left out rather than ended without a start*/
+        int first = SDL_max(count - TRACE_EVENTS_PER_THREAD, 0);
+        int depth = 0;
+        for (int i = first; i < count; ++i)
+        {
+            struct traceEvent *event = &thread->Events[i % TRACE_EVENTS_PER_THREAD];
+            depth += event->Phase == 'B' ? 1 : -1;
+            if (depth < 0)
+            {
+                depth = 0;
+                continue;
+            }
+            SDL_IOprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%" SDL_PRIu64 "}",
+                         separator, event->Name, event->Phase, (double)(event->Ticks - startTicks) * microsecondsPerTick, (Uint64)thread->ThreadId);
+            separator = ",\n";
+        }
+        if (first > 0)
+        {
+            SDL_Log("Trace: kept the newest %d events of thread %s, %d older ones were overwritten.", TRACE_EVENTS_PER_THREAD,
+                    thread->Name ? thread->Name : "?", first);
+        }
+        if (thread->Dropped > 0)
+        {
+            SDL_Log("Trace: %d events dropped on thread %s, its buffer could not be allocated.", thread->Dropped, thread->Name ? thread->Name : "?");
+        }
+
+        SDL_SetAtomicInt(&thread->Count, 0);
+        thread->Dropped = 0;
+    }
+    SDL_IOprintf(file, "\n]}\n");
+
+    return SDL_CloseIO(file) ? 0 : -1;
+}
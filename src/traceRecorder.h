@@ -0,0 +1,27 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <SDL3/SDL.h>
+
+/* Most threads that can record events*/
+#define TRACE_MAX_THREADS 64
+/* Events kept per thread between two flushes, the newest ones overwrite the oldest*/
+#define TRACE_EVENTS_PER_THREAD (1 << 16)
+
+/* This function turns recording on. Each thread allocates its buffer on its first event.*/
+void StartTraceRecorder(void);
+/* This function turns recording off and frees the buffers.*/
+void StopTraceRecorder(void);
+bool IsTraceRecording(void);
+
+/* This function names the calling thread in the trace. Threads that never call it are named by their id.*/
+void SetTraceThreadName(const char *Name);
+/* These functions record the start and end of a span on the calling thread. Name must outlive the recorder.*/
+void TraceBegin(const char *Name);
+void TraceEnd(const char *Name);
+
+/* This function writes everything recorded so far as Chrome trace-event JSON and empties the buffers.
+   Must be called while no other thread is recording, e.g. between frames. Returns -1 if the file cannot be written. */
+int FlushTraceRecorder(const char *Path);
+
+#endif
@@ -0,0 +1,74 @@
+#include "trail.h"
+
+void resetTrailSampler(struct TrailSampler *sampler)
+{
+    sampler->active = 0;
+    sampler->hasDirection = 0;
+}
+
+/* This function emits a sample and restarts the current segment from it*/
+static void emitSample(struct TrailSampler *sampler, struct cirBuffer *trailBuffer, float x, float y)
+{
+    writeCirBuffer(trailBuffer, x, y);
+    sampler->anchorX = x;
+    sampler->anchorY = y;
+    sampler->lastX = x;
+    sampler->lastY = y;
+    sampler->hasDirection = 0;
+}
+
+/* This function feeds the newest position of a body into its trail.
+   Only squared distances and a cross product are used, so there is no sqrt per body per frame. */
+void sampleTrail(struct TrailSampler *sampler, struct cirBuffer *trailBuffer, float x, float y)
+{
+    if (!sampler->active)
+    {
+        sampler->active = 1;
+        emitSample(sampler, trailBuffer, x, y);
+        return;
+    }
+
+    float ex = x - sampler->anchorX;
+    float ey = y - sampler->anchorY;
+    float distanceSquared = ex * ex + ey * ey;
+
+    /* Segment too long, close it at the current position*/
+    if (distanceSquared > TRAIL_MAX_SPACING * TRAIL_MAX_SPACING)
+    {
+        emitSample(sampler, trailBuffer, x, y);
+        return;
+    }
+
+    if (!sampler->hasDirection)
+    {
+        /* Wait until the body has moved far enough to give a stable direction*/
+        if (distanceSquared > TRAIL_TOLERANCE * TRAIL_TOLERANCE)
+        {
+            sampler->dirX = ex;
+            sampler->dirY = ey;
+            sampler->hasDirection = 1;
+        }
+        sampler->lastX = x;
+        sampler->lastY = y;
+        return;
+    }
+
+    /* Distance of the new position from the line through the anchor, scaled by |dir|*/
+    float cross = ex * sampler->dirY - ey * sampler->dirX;
+    float dirLengthSquared = sampler->dirX * sampler->dirX + sampler->dirY * sampler->dirY;
+    int turnedBack = ex * sampler->dirX + ey * sampler->dirY < 0.0f;
+
+    if (turnedBack || cross * cross > TRAIL_TOLERANCE * TRAIL_TOLERANCE * dirLengthSquared)
+    {
+        /* The previous position was still within tolerance, so it becomes the corner of the path*/
+        float cornerX = sampler->lastX;
+        float cornerY = sampler->lastY;
+        emitSample(sampler, trailBuffer, cornerX, cornerY);
+
+        sampler->dirX = x - cornerX;
+        sampler->dirY = y - cornerY;
+        sampler->hasDirection = sampler->dirX * sampler->dirX + sampler->dirY * sampler->dirY > TRAIL_TOLERANCE * TRAIL_TOLERANCE;
+    }
+    sampler->lastX = x;
+    sampler->lastY = y;
+}
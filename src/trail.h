@@ -0,0 +1,35 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include "circularBuffer.h"
+
+/* Largest distance (world units) the path may stray from the last emitted segment before a new sample is written */
+#define TRAIL_TOLERANCE 0.75f
+/* Largest distance (world units) between two samples, even on a straight path */
+#define TRAIL_MAX_SPACING 60.0f
+
+/* Adaptive trail sampler.
+   A sample is only emitted when the path bends away from the current segment or the segment grows too long,
+   so straight or slow motion costs almost no samples. */
+struct TrailSampler
+{
+    int active;
+    int hasDirection;
+
+    /* Last emitted sample*/
+    float anchorX;
+    float anchorY;
+
+    /* Direction of travel when leaving the anchor (not normalised)*/
+    float dirX;
+    float dirY;
+
+    /* Most recent position seen since the anchor*/
+    float lastX;
+    float lastY;
+};
+
+void resetTrailSampler(struct TrailSampler *sampler);
+void sampleTrail(struct TrailSampler *sampler, struct cirBuffer *trailBuffer, float x, float y);
+
+#endif
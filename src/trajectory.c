@@ -0,0 +1,556 @@
+#include "trajectory.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRAJECTORY_MMAP 1
+#endif
+
+/* Frames indexed before the index first grows*/
+#define INITIAL_INDEX_CAPACITY 256
+
+static size_t recordSize(Uint32 Type)
+{
+    return Type == TRAJECTORY_KEYFRAME ? TRAJECTORY_FIELDS * sizeof(float) : 2 * sizeof(Sint16);
+}
+
+static size_t frameSize(Uint32 Type, int Count)
+{
+    return TRAJECTORY_FRAME_HEADER_SIZE + (size_t)Count * recordSize(Type);
+}
+
+static void putUint32(char *Destination, Uint32 Value)
+{
+    Value = SDL_Swap32LE(Value);
+    SDL_memcpy(Destination, &Value, sizeof(Value));
+}
+
+static void putUint64(char *Destination, Uint64 Value)
+{
+    Value = SDL_Swap64LE(Value);
+    SDL_memcpy(Destination, &Value, sizeof(Value));
+}
+
+static Uint32 getUint32(const Uint8 *Source)
+{
+    Uint32 value;
+    SDL_memcpy(&value, Source, sizeof(value));
+    return SDL_Swap32LE(value);
+}
+
+static Uint64 getUint64(const Uint8 *Source)
+{
+    Uint64 value;
+    SDL_memcpy(&value, Source, sizeof(value));
+    return SDL_Swap64LE(value);
+}
+
+static Uint64 timeBits(double Time)
+{
+    Uint64 bits;
+    SDL_memcpy(&bits, &Time, sizeof(bits));
+    return bits;
+}
+
+static double timeOfBits(Uint64 Bits)
+{
+    double time;
+    SDL_memcpy(&time, &Bits, sizeof(time));
+    return time;
+}
+
+/* This function makes room for one more index entry. Returns -1 when out of memory.*/
+static int growIndex(struct TrajectoryIndexEntry **Index, int NumFrames, int *Capacity)
+{
+    if (NumFrames < *Capacity)
+    {
+        return 0;
+    }
+    int capacity = *Capacity > 0 ? *Capacity * 2 : INITIAL_INDEX_CAPACITY;
+    struct TrajectoryIndexEntry *index = SDL_realloc(*Index, capacity * sizeof(struct TrajectoryIndexEntry));
+    if (index == NULL)
+    {
+        return -1;
+    }
+    *Index = index;
+    *Capacity = capacity;
+    return 0;
+}
+
+int OpenTrajectoryWriter(struct TrajectoryWriter *Writer, const char *Path)
+{
+    SDL_zerop(Writer);
+    Writer->Stream = SDL_IOFromFile(Path, "wb");
+    if (Writer->Stream == NULL)
+    {
+        return -1;
+    }
+
+    char header[TRAJECTORY_HEADER_SIZE];
+    SDL_memcpy(header, TRAJECTORY_MAGIC, 4);
+    putUint32(header + 4, TRAJECTORY_VERSION);
+    if (SDL_WriteIO(Writer->Stream, header, sizeof(header)) != sizeof(header))
+    {
+        SDL_CloseIO(Writer->Stream);
+        Writer->Stream = NULL;
+        return -1;
+    }
+    Writer->Offset = TRAJECTORY_HEADER_SIZE;
+    return 0;
+}
+
+/* This function stores the moves since the last frame as deltas. Returns 0 when one is too far for a delta, or a body changed size.*/
+static int encodeDeltas(struct TrajectoryWriter *Writer, const struct ObjectList *Objects, Sint16 *Records)
+{
+    for (int i = 0; i < Objects->NumItems; ++i)
+    {
+        const struct Object *body = &Objects->Data[i];
+        const float *rebuilt = &Writer->Rebuilt[i * TRAJECTORY_FIELDS];
+        float stepX = (body->x - rebuilt[0]) / TRAJECTORY_DELTA_QUANTUM;
+        float stepY = (body->y - rebuilt[1]) / TRAJECTORY_DELTA_QUANTUM;
+        /* Written this way round, a position that is not a number also ends up in a keyframe*/
+        if (!(SDL_fabsf(stepX) < SDL_MAX_SINT16 && SDL_fabsf(stepY) < SDL_MAX_SINT16) || body->size != rebuilt[2])
+        {
+            return 0;
+        }
+        Records[i * 2] = (Sint16)SDL_lroundf(stepX);
+        Records[i * 2 + 1] = (Sint16)SDL_lroundf(stepY);
+    }
+
+    /* Move on exactly as a reader will, from the rounded steps*/
+    for (int i = 0; i < Objects->NumItems; ++i)
+    {
+        float *rebuilt = &Writer->Rebuilt[i * TRAJECTORY_FIELDS];
+        rebuilt[0] += Records[i * 2] * TRAJECTORY_DELTA_QUANTUM;
+        rebuilt[1] += Records[i * 2 + 1] * TRAJECTORY_DELTA_QUANTUM;
+        Records[i * 2] = (Sint16)SDL_Swap16LE((Uint16)Records[i * 2]);
+        Records[i * 2 + 1] = (Sint16)SDL_Swap16LE((Uint16)Records[i * 2 + 1]);
+    }
+    return 1;
+}
+
+int WriteTrajectoryFrame(struct TrajectoryWriter *Writer, const struct ObjectList *Objects, double Time)
+{
+    int count = Objects->NumItems;
+    size_t size = frameSize(TRAJECTORY_KEYFRAME, count);
+    if (size > Writer->StagingCapacity)
+    {
+        /* Leave room to grow, so spawning a few bodies does not reallocate every frame*/
+        size_t capacity = size + size / 2;
+        char *staging = SDL_realloc(Writer->Staging, capacity);
+        if (staging == NULL)
+        {
+            return -1;
+        }
+        Writer->Staging = staging;
+        Writer->StagingCapacity = capacity;
+    }
+    if (count > Writer->RebuiltCapacity)
+    {
+        int capacity = count + count / 2;
+        float *rebuilt = SDL_realloc(Writer->Rebuilt, (size_t)capacity * TRAJECTORY_FIELDS * sizeof(float));
+        if (rebuilt == NULL)
+        {
+            return -1;
+        }
+        Writer->Rebuilt = rebuilt;
+        Writer->RebuiltCapacity = capacity;
+    }
+    if (growIndex(&Writer->Index, Writer->NumFrames, &Writer->IndexCapacity) != 0)
+    {
+        return -1;
+    }
+
+    int lastKeyframe = Writer->NumFrames > 0 ? Writer->Index[Writer->NumFrames - 1].Keyframe : 0;
+    Uint32 type = TRAJECTORY_DELTA_FRAME;
+    if (Writer->NumFrames == 0 || count != Writer->NumRebuilt || Writer->NumFrames - lastKeyframe >= TRAJECTORY_KEYFRAME_INTERVAL ||
+        !encodeDeltas(Writer, Objects, (Sint16 *)(Writer->Staging + TRAJECTORY_FRAME_HEADER_SIZE)))
+    {
+        type = TRAJECTORY_KEYFRAME;
+        float *record = (float *)(Writer->Staging + TRAJECTORY_FRAME_HEADER_SIZE);
+        for (int i = 0; i < count; ++i, record += TRAJECTORY_FIELDS)
+        {
+            const struct Object *body = &Objects->Data[i];
+            float *rebuilt = &Writer->Rebuilt[i * TRAJECTORY_FIELDS];
+            rebuilt[0] = body->x;
+            rebuilt[1] = body->y;
+            rebuilt[2] = body->size;
+            record[0] = SDL_SwapFloatLE(body->x);
+            record[1] = SDL_SwapFloatLE(body->y);
+            record[2] = SDL_SwapFloatLE(body->size);
+        }
+        Writer->NumRebuilt = count;
+        lastKeyframe = Writer->NumFrames;
+        ++Writer->NumKeyframes;
+    }
+
+    putUint64(Writer->Staging, timeBits(Time));
+    putUint32(Writer->Staging + 8, (Uint32)count);
+    putUint32(Writer->Staging + 12, type);
+    size = frameSize(type, count);
+    if (SDL_WriteIO(Writer->Stream, Writer->Staging, size) != size)
+    {
+        /* The rebuilt bodies may be ahead of the file, the next frame starts over with a keyframe*/
+        Writer->NumRebuilt = -1;
+        return -1;
+    }
+
+    Writer->Index[Writer->NumFrames++] = (struct TrajectoryIndexEntry){Time, Writer->Offset, lastKeyframe, count};
+    Writer->Offset += size;
+    return 0;
+}
+
+int CloseTrajectoryWriter(struct TrajectoryWriter *Writer)
+{
+    int result = 0;
+    if (Writer->Stream != NULL)
+    {
+        size_t size = (size_t)Writer->NumFrames * TRAJECTORY_INDEX_ENTRY_SIZE + TRAJECTORY_TRAILER_SIZE;
+        char *index = SDL_malloc(size);
+        if (index != NULL)
+        {
+            char *entry = index;
+            for (int i = 0; i < Writer->NumFrames; ++i, entry += TRAJECTORY_INDEX_ENTRY_SIZE)
+            {
+                putUint64(entry, timeBits(Writer->Index[i].Time));
+                putUint64(entry + 8, Writer->Index[i].Offset);
+                putUint32(entry + 16, (Uint32)Writer->Index[i].Keyframe);
+                putUint32(entry + 20, (Uint32)Writer->Index[i].NumBodies);
+            }
+            putUint64(entry, Writer->Offset);
+            putUint64(entry + 8, (Uint64)Writer->NumFrames);
+            putUint32(entry + 16, 0);
+            SDL_memcpy(entry + 20, TRAJECTORY_INDEX_MAGIC, 4);
+        }
+        /* Without its index the file still reads, it is only slower to open*/
+        if (index == NULL || SDL_WriteIO(Writer->Stream, index, size) != size)
+        {
+            result = -1;
+        }
+        SDL_free(index);
+        if (!SDL_CloseIO(Writer->Stream))
+        {
+            result = -1;
+        }
+    }
+    SDL_free(Writer->Staging);
+    SDL_free(Writer->Rebuilt);
+    SDL_free(Writer->Index);
+    SDL_zerop(Writer);
+    return result;
+}
+
+static int mapTrajectory(struct Trajectory *Trajectory, const char *Path)
+{
+#ifdef TRAJECTORY_MMAP
+    int fd = open(Path, O_RDONLY);
+    if (fd < 0)
+    {
+        SDL_SetError("Couldn't open %s", Path);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < TRAJECTORY_HEADER_SIZE)
+    {
+        close(fd);
+        SDL_SetError("%s: not a trajectory file", Path);
+        return -1;
+    }
+    /* Pages are only read in as frames are visited, however long the recording*/
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        SDL_SetError("Couldn't map %s", Path);
+        return -1;
+    }
+    Trajectory->Data = data;
+    Trajectory->Size = (size_t)info.st_size;
+    Trajectory->Mapped = 1;
+    return 0;
+#else
+    size_t size;
+    void *data = SDL_LoadFile(Path, &size);
+    if (data == NULL)
+    {
+        return -1;
+    }
+    if (size < TRAJECTORY_HEADER_SIZE)
+    {
+        SDL_free(data);
+        SDL_SetError("%s: not a trajectory file", Path);
+        return -1;
+    }
+    Trajectory->Data = data;
+    Trajectory->Size = size;
+    return 0;
+#endif
+}
+
+/* This function reads the index written when the recording finished. Returns 0 when the file has none or it does not fit the file, -1 when out of memory.*/
+static int readIndex(struct Trajectory *Trajectory)
+{
+    if (Trajectory->Size < TRAJECTORY_HEADER_SIZE + TRAJECTORY_TRAILER_SIZE)
+    {
+        return 0;
+    }
+    const Uint8 *trailer = Trajectory->Data + Trajectory->Size - TRAJECTORY_TRAILER_SIZE;
+    Uint64 indexOffset = getUint64(trailer);
+    Uint64 count = getUint64(trailer + 8);
+    if (SDL_memcmp(trailer + 20, TRAJECTORY_INDEX_MAGIC, 4) != 0 || count == 0 || count > (Uint64)SDL_MAX_SINT32 ||
+        indexOffset < TRAJECTORY_HEADER_SIZE + TRAJECTORY_FRAME_HEADER_SIZE ||
+        indexOffset + count * TRAJECTORY_INDEX_ENTRY_SIZE != Trajectory->Size - TRAJECTORY_TRAILER_SIZE)
+    {
+        return 0;
+    }
+
+    Trajectory->Index = SDL_malloc(count * sizeof(struct TrajectoryIndexEntry));
+    if (Trajectory->Index == NULL)
+    {
+        return -1;
+    }
+    /* Only the index is checked here, frames are checked as they are read, so opening does not touch the rest of the file*/
+    const Uint8 *entry = Trajectory->Data + indexOffset;
+    for (int i = 0; i < (int)count; ++i, entry += TRAJECTORY_INDEX_ENTRY_SIZE)
+    {
+        struct TrajectoryIndexEntry *frame = &Trajectory->Index[i];
+        frame->Time = timeOfBits(getUint64(entry));
+        frame->Offset = getUint64(entry + 8);
+        frame->Keyframe = (int)getUint32(entry + 16);
+        frame->NumBodies = (int)getUint32(entry + 20);
+        if (frame->Offset < TRAJECTORY_HEADER_SIZE || frame->Offset > indexOffset - TRAJECTORY_FRAME_HEADER_SIZE ||
+            frame->Keyframe < 0 || frame->Keyframe > i || frame->NumBodies < 0 || (i > 0 && !(frame->Time >= frame[-1].Time)) ||
+            /* A frame must point at a keyframe and hold as many bodies, seeking sizes the cursor for the target frame only*/
+            Trajectory->Index[frame->Keyframe].Keyframe != frame->Keyframe || Trajectory->Index[frame->Keyframe].NumBodies != frame->NumBodies)
+        {
+            SDL_free(Trajectory->Index);
+            Trajectory->Index = NULL;
+            return 0;
+        }
+    }
+    Trajectory->NumFrames = (int)count;
+    return 1;
+}
+
+/* This function indexes a file without one, frame by frame. Returns -1 when out of memory.*/
+static int scanFrames(struct Trajectory *Trajectory, const char *Path)
+{
+    int capacity = 0;
+    int keyframe = -1;
+    size_t offset = TRAJECTORY_HEADER_SIZE;
+    while (offset < Trajectory->Size)
+    {
+        const Uint8 *header = Trajectory->Data + offset;
+        size_t left = Trajectory->Size - offset;
+        Uint32 count = left >= TRAJECTORY_FRAME_HEADER_SIZE ? getUint32(header + 8) : 0;
+        Uint32 type = left >= TRAJECTORY_FRAME_HEADER_SIZE ? getUint32(header + 12) : 0;
+        double time = left >= TRAJECTORY_FRAME_HEADER_SIZE ? timeOfBits(getUint64(header)) : 0.0;
+        /* A recording stopped by a crash ends in a partial frame, everything before it is still usable.
+           Times must not go back, or searching by time would go astray */
+        if (left < TRAJECTORY_FRAME_HEADER_SIZE || count > (Uint32)SDL_MAX_SINT32 || type > TRAJECTORY_DELTA_FRAME ||
+            left < frameSize(type, (int)count) ||
+            (Trajectory->NumFrames > 0 && !(time >= Trajectory->Index[Trajectory->NumFrames - 1].Time)) ||
+            (type == TRAJECTORY_DELTA_FRAME && (keyframe < 0 || (int)count != Trajectory->Index[keyframe].NumBodies)))
+        {
+            SDL_Log("%s: frame %d is cut short or damaged, ignoring the rest of the file", Path, Trajectory->NumFrames);
+            break;
+        }
+
+        if (growIndex(&Trajectory->Index, Trajectory->NumFrames, &capacity) != 0)
+        {
+            return -1;
+        }
+        if (type == TRAJECTORY_KEYFRAME)
+        {
+            keyframe = Trajectory->NumFrames;
+        }
+        Trajectory->Index[Trajectory->NumFrames++] = (struct TrajectoryIndexEntry){time, offset, keyframe, (int)count};
+        offset += frameSize(type, (int)count);
+    }
+    return 0;
+}
+
+int OpenTrajectory(struct Trajectory *Trajectory, const char *Path)
+{
+    SDL_zerop(Trajectory);
+    if (mapTrajectory(Trajectory, Path) != 0)
+    {
+        return -1;
+    }
+    if (SDL_memcmp(Trajectory->Data, TRAJECTORY_MAGIC, 4) != 0 || getUint32(Trajectory->Data + 4) != TRAJECTORY_VERSION)
+    {
+        CloseTrajectory(Trajectory);
+        SDL_SetError("%s: not a version %d trajectory file", Path, TRAJECTORY_VERSION);
+        return -1;
+    }
+
+    int indexed = readIndex(Trajectory);
+    if (indexed == 0)
+    {
+        SDL_Log("%s has no index, the recording did not finish. Scanning its frames", Path);
+        indexed = scanFrames(Trajectory, Path);
+    }
+    if (indexed < 0)
+    {
+        CloseTrajectory(Trajectory);
+        SDL_SetError("out of memory for the index of %s", Path);
+        return -1;
+    }
+    if (Trajectory->NumFrames == 0)
+    {
+        CloseTrajectory(Trajectory);
+        SDL_SetError("%s: no frames", Path);
+        return -1;
+    }
+    return 0;
+}
+
+int FindTrajectoryFrame(const struct Trajectory *Trajectory, double Time)
+{
+    /* Frames are in time order, find the first one after Time*/
+    int low = 0;
+    int high = Trajectory->NumFrames;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (Trajectory->Index[middle].Time <= Time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return SDL_max(low - 1, 0);
+}
+
+/* This function applies one frame to the cursor, which holds the frame before it unless this is a keyframe. Returns -1 when the frame is damaged.*/
+static int applyFrame(const struct Trajectory *Trajectory, struct TrajectoryCursor *Cursor, int Frame)
+{
+    const struct TrajectoryIndexEntry *entry = &Trajectory->Index[Frame];
+    const Uint8 *header = Trajectory->Data + entry->Offset;
+    Uint32 type = getUint32(header + 12);
+    if (getUint32(header + 8) != (Uint32)entry->NumBodies || entry->NumBodies > Cursor->Capacity || type > TRAJECTORY_DELTA_FRAME ||
+        frameSize(type, entry->NumBodies) > Trajectory->Size - entry->Offset ||
+        (type == TRAJECTORY_DELTA_FRAME && (Frame == entry->Keyframe || Cursor->NumBodies != entry->NumBodies)))
+    {
+        SDL_SetError("trajectory frame %d is damaged", Frame);
+        return -1;
+    }
+
+    const Uint8 *record = header + TRAJECTORY_FRAME_HEADER_SIZE;
+    if (type == TRAJECTORY_KEYFRAME)
+    {
+        for (int i = 0; i < entry->NumBodies; ++i, record += TRAJECTORY_FIELDS * sizeof(float))
+        {
+            float fields[TRAJECTORY_FIELDS];
+            SDL_memcpy(fields, record, sizeof(fields));
+            Cursor->X[i] = SDL_SwapFloatLE(fields[0]);
+            Cursor->Y[i] = SDL_SwapFloatLE(fields[1]);
+            Cursor->Size[i] = SDL_SwapFloatLE(fields[2]);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < entry->NumBodies; ++i, record += 2 * sizeof(Sint16))
+        {
+            Uint16 steps[2];
+            SDL_memcpy(steps, record, sizeof(steps));
+            Cursor->X[i] += (Sint16)SDL_Swap16LE(steps[0]) * TRAJECTORY_DELTA_QUANTUM;
+            Cursor->Y[i] += (Sint16)SDL_Swap16LE(steps[1]) * TRAJECTORY_DELTA_QUANTUM;
+        }
+    }
+    Cursor->NumBodies = entry->NumBodies;
+    return 0;
+}
+
+int SeekTrajectory(const struct Trajectory *Trajectory, struct TrajectoryCursor *Cursor, int Frame)
+{
+    const struct TrajectoryIndexEntry *entry = &Trajectory->Index[Frame];
+    /* Playing forward only needs the frames since the cursor, as long as they share its keyframe*/
+    int from = entry->Keyframe;
+    if (Cursor->X != NULL && Cursor->Frame >= entry->Keyframe && Cursor->Frame <= Frame)
+    {
+        from = Cursor->Frame + 1;
+    }
+
+    if (entry->NumBodies > Cursor->Capacity)
+    {
+        int capacity = entry->NumBodies + entry->NumBodies / 2;
+        float *x = SDL_realloc(Cursor->X, (size_t)capacity * sizeof(float));
+        Cursor->X = x != NULL ? x : Cursor->X;
+        float *y = SDL_realloc(Cursor->Y, (size_t)capacity * sizeof(float));
+        Cursor->Y = y != NULL ? y : Cursor->Y;
+        float *size = SDL_realloc(Cursor->Size, (size_t)capacity * sizeof(float));
+        Cursor->Size = size != NULL ? size : Cursor->Size;
+        if (x == NULL || y == NULL || size == NULL)
+        {
+            Cursor->Frame = -1;
+            SDL_SetError("out of memory for %d bodies", entry->NumBodies);
+            return -1;
+        }
+        Cursor->Capacity = capacity;
+    }
+
+    for (int frame = from; frame <= Frame; ++frame)
+    {
+        if (applyFrame(Trajectory, Cursor, frame) != 0)
+        {
+            Cursor->Frame = -1;
+            return -1;
+        }
+    }
+    Cursor->Frame = Frame;
+    Cursor->Time = entry->Time;
+    return 0;
+}
+
+int StreamTrajectory(const struct Trajectory *Trajectory, struct TrajectoryCursor *Cursor, double StartTime, double EndTime,
+                     TrajectoryCallback Callback, void *UserData)
+{
+    int frame = FindTrajectoryFrame(Trajectory, StartTime);
+    if (Trajectory->Index[frame].Time < StartTime)
+    {
+        ++frame;
+    }
+
+    int streamed = 0;
+    for (; frame < Trajectory->NumFrames && Trajectory->Index[frame].Time <= EndTime; ++frame)
+    {
+        if (SeekTrajectory(Trajectory, Cursor, frame) != 0)
+        {
+            return -1;
+        }
+        ++streamed;
+        if (Callback(UserData, Cursor) != 0)
+        {
+            break;
+        }
+    }
+    return streamed;
+}
+
+void ClearTrajectoryCursor(struct TrajectoryCursor *Cursor)
+{
+    SDL_free(Cursor->X);
+    SDL_free(Cursor->Y);
+    SDL_free(Cursor->Size);
+    SDL_zerop(Cursor);
+}
+
+void CloseTrajectory(struct Trajectory *Trajectory)
+{
+#ifdef TRAJECTORY_MMAP
+    if (Trajectory->Mapped)
+    {
+        munmap((void *)Trajectory->Data, Trajectory->Size);
+    }
+#else
+    SDL_free((void *)Trajectory->Data);
+#endif
+    SDL_free(Trajectory->Index);
+    SDL_zerop(Trajectory);
+}
@@ -0,0 +1,114 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <SDL3/SDL.h>
+
+#include "objects.h"
+
+/* Trajectory files start with this tag and a little-endian Uint32 version, followed by frames and, once recording has finished, an index.
+   A frame is a Uint64 holding the bits of its double simulation time in seconds, a Uint32 body count and a Uint32 frame type,
+   then one record per body. Bodies keep their index from frame to frame.
+   Keyframes hold TRAJECTORY_FIELDS little-endian floats per body: x, y, radius.
+   Delta frames hold two little-endian Sint16 per body, the move in x and y since the previous frame in steps of TRAJECTORY_DELTA_QUANTUM.
+   Deltas are taken from the positions a reader rebuilds rather than the exact ones, so rounding never adds up over frames. */
+#define TRAJECTORY_MAGIC "GMST"
+#define TRAJECTORY_VERSION 2
+#define TRAJECTORY_HEADER_SIZE 8
+#define TRAJECTORY_FRAME_HEADER_SIZE 16
+#define TRAJECTORY_FIELDS 3
+#define TRAJECTORY_DELTA_QUANTUM (1.0f / 64.0f)
+/* A keyframe is written at least this often, and whenever bodies are added, removed or resized, or one moves too far for a delta*/
+#define TRAJECTORY_KEYFRAME_INTERVAL 64
+
+enum TrajectoryFrameType
+{
+    TRAJECTORY_KEYFRAME,
+    TRAJECTORY_DELTA_FRAME
+};
+
+/* The index holds one entry per frame: a Uint64 of the time bits, the Uint64 file offset of the frame, a Uint32 index of its keyframe
+   and a Uint32 body count. It is followed by a trailer of the Uint64 offset of the index, the Uint64 frame count, a Uint32 of zero and this tag.
+   A recording that never finished has no index, and is scanned frame by frame instead. */
+#define TRAJECTORY_INDEX_MAGIC "GMSI"
+#define TRAJECTORY_INDEX_ENTRY_SIZE 24
+#define TRAJECTORY_TRAILER_SIZE 24
+
+struct TrajectoryIndexEntry
+{
+    double Time;
+    Uint64 Offset;
+    int Keyframe;
+    int NumBodies;
+};
+
+/* Appends the bodies of every recorded frame to a trajectory file, one write per frame, and the index when closed*/
+struct TrajectoryWriter
+{
+    SDL_IOStream *Stream;
+    /* File offset of the next frame*/
+    Uint64 Offset;
+    char *Staging;
+    size_t StagingCapacity;
+
+    /* Bodies as a reader rebuilds them after the last frame, TRAJECTORY_FIELDS floats each*/
+    float *Rebuilt;
+    int RebuiltCapacity;
+    int NumRebuilt;
+
+    int NumFrames;
+    int IndexCapacity;
+    struct TrajectoryIndexEntry *Index;
+    int NumKeyframes;
+};
+
+/* A trajectory file mapped into memory, with the index of its frames in time order*/
+struct Trajectory
+{
+    const Uint8 *Data;
+    size_t Size;
+    int Mapped;
+
+    int NumFrames;
+    struct TrajectoryIndexEntry *Index;
+};
+
+/* The bodies of one frame, rebuilt from the keyframe before it, one array per field for analysis loops. A zeroed cursor is ready to use.*/
+struct TrajectoryCursor
+{
+    /* Frame the arrays hold, -1 when they hold none*/
+    int Frame;
+    double Time;
+
+    int NumBodies;
+    int Capacity;
+    float *X;
+    float *Y;
+    float *Size;
+};
+
+/* Called for every frame of a streamed range with the cursor on it. Returns nonzero to stop the stream.*/
+typedef int (*TrajectoryCallback)(void *UserData, const struct TrajectoryCursor *Cursor);
+
+/* This function creates Path and writes the header. Returns -1 and sets the SDL error on failure.*/
+int OpenTrajectoryWriter(struct TrajectoryWriter *Writer, const char *Path);
+/* This function appends the bodies as they are at simulation time Time. Returns -1 and sets the SDL error on failure.*/
+int WriteTrajectoryFrame(struct TrajectoryWriter *Writer, const struct ObjectList *Objects, double Time);
+/* This function writes the index and closes the file. Returns -1 and sets the SDL error when the file is incomplete.*/
+int CloseTrajectoryWriter(struct TrajectoryWriter *Writer);
+
+/* This function maps Path and reads its index, or rebuilds it when the recording never finished.
+   Returns -1 and sets the SDL error when the file is not a trajectory. */
+int OpenTrajectory(struct Trajectory *Trajectory, const char *Path);
+/* This function returns the index of the last frame at or before Time, or 0 when Time comes before the first frame.*/
+int FindTrajectoryFrame(const struct Trajectory *Trajectory, double Time);
+/* This function rebuilds the bodies of Frame in the cursor. Moving forward from the cursor's frame only applies the deltas in between,
+   anything else starts over at the keyframe of Frame. Returns -1 and sets the SDL error when the frame is damaged or memory runs out. */
+int SeekTrajectory(const struct Trajectory *Trajectory, struct TrajectoryCursor *Cursor, int Frame);
+/* This function hands every frame from StartTime to EndTime to Callback, rebuilt straight from the mapped file into the cursor.
+   Returns the number of frames handed over, or -1 and sets the SDL error on failure. */
+int StreamTrajectory(const struct Trajectory *Trajectory, struct TrajectoryCursor *Cursor, double StartTime, double EndTime,
+                     TrajectoryCallback Callback, void *UserData);
+void ClearTrajectoryCursor(struct TrajectoryCursor *Cursor);
+void CloseTrajectory(struct Trajectory *Trajectory);
+
+#endif
@@ -0,0 +1,133 @@
+#include "vertexBatch.h"
+
+void BindVertexBatch(struct VertexBatch *WishedBatch, struct FrameArena *Arena)
+{
+    if (WishedBatch->Arena == NULL)
+    {
+        SDL_free(WishedBatch->Vertices);
+        SDL_free(WishedBatch->Indices);
+    }
+    WishedBatch->Arena = Arena;
+    WishedBatch->Vertices = NULL;
+    WishedBatch->Indices = NULL;
+    WishedBatch->VertexCapacity = 0;
+    WishedBatch->IndexCapacity = 0;
+    ResetVertexBatch(WishedBatch);
+
+    /* Take last frame's size straight away so a steady frame never has to copy*/
+    GrowArray(Arena, (void **)&WishedBatch->Vertices, &WishedBatch->VertexCapacity, 0, WishedBatch->PeakVertices, sizeof(SDL_Vertex));
+    GrowArray(Arena, (void **)&WishedBatch->Indices, &WishedBatch->IndexCapacity, 0, WishedBatch->PeakIndices, sizeof(int));
+}
+
+int ReserveVertexBatch(struct VertexBatch *WishedBatch, int NumVertices, int NumIndices)
+{
+    if (GrowArray(WishedBatch->Arena, (void **)&WishedBatch->Vertices, &WishedBatch->VertexCapacity, WishedBatch->NumVertices, WishedBatch->NumVertices + NumVertices, sizeof(SDL_Vertex)) != 0 ||
+        GrowArray(WishedBatch->Arena, (void **)&WishedBatch->Indices, &WishedBatch->IndexCapacity, WishedBatch->NumIndices, WishedBatch->NumIndices + NumIndices, sizeof(int)) != 0)
+    {
+        return -1;
+    }
+
+    int first = WishedBatch->NumVertices;
+    WishedBatch->NumVertices += NumVertices;
+    WishedBatch->NumIndices += NumIndices;
+    return first;
+}
+
+int AddQuadToBatch(struct VertexBatch *WishedBatch, const SDL_Vertex Corners[4])
+{
+    int first = ReserveVertexBatch(WishedBatch, 4, 6);
+    if (first < 0)
+    {
+        return -1;
+    }
+
+    SDL_memcpy(&WishedBatch->Vertices[first], Corners, 4 * sizeof(SDL_Vertex));
+
+    int *indices = &WishedBatch->Indices[WishedBatch->NumIndices - 6];
+    indices[0] = first;
+    indices[1] = first + 1;
+    indices[2] = first + 2;
+    indices[3] = first;
+    indices[4] = first + 2;
+    indices[5] = first + 3;
+    return 0;
+}
+
+bool FlushVertexBatch(SDL_Renderer *Renderer, struct VertexBatch *WishedBatch, SDL_Texture *Texture)
+{
+    bool result = true;
+    WishedBatch->PeakVertices = SDL_max(WishedBatch->PeakVertices, WishedBatch->NumVertices);
+    WishedBatch->PeakIndices = SDL_max(WishedBatch->PeakIndices, WishedBatch->NumIndices);
+    if (WishedBatch->NumIndices > 0)
+    {
+        result = SDL_RenderGeometry(Renderer, Texture, WishedBatch->Vertices, WishedBatch->NumVertices, WishedBatch->Indices, WishedBatch->NumIndices);
+    }
+    ResetVertexBatch(WishedBatch);
+    return result;
+}
+
+void ResetVertexBatch(struct VertexBatch *WishedBatch)
+{
+    WishedBatch->NumVertices = 0;
+    WishedBatch->NumIndices = 0;
+}
+
+void ClearVertexBatch(struct VertexBatch *WishedBatch)
+{
+    if (WishedBatch->Arena == NULL)
+    {
+        SDL_free(WishedBatch->Vertices);
+        SDL_free(WishedBatch->Indices);
+    }
+    WishedBatch->Vertices = NULL;
+    WishedBatch->Indices = NULL;
+    WishedBatch->VertexCapacity = 0;
+    WishedBatch->IndexCapacity = 0;
+    ResetVertexBatch(WishedBatch);
+}
+
+void BindPointBatch(struct PointBatch *WishedBatch, struct FrameArena *Arena)
+{
+    if (WishedBatch->Arena == NULL)
+    {
+        SDL_free(WishedBatch->Points);
+    }
+    WishedBatch->Arena = Arena;
+    WishedBatch->Points = NULL;
+    WishedBatch->Capacity = 0;
+    WishedBatch->NumPoints = 0;
+    GrowArray(Arena, (void **)&WishedBatch->Points, &WishedBatch->Capacity, 0, WishedBatch->PeakPoints, sizeof(SDL_FPoint));
+}
+
+int AddPointToBatch(struct PointBatch *WishedBatch, float x, float y)
+{
+    if (GrowArray(WishedBatch->Arena, (void **)&WishedBatch->Points, &WishedBatch->Capacity, WishedBatch->NumPoints, WishedBatch->NumPoints + 1, sizeof(SDL_FPoint)) != 0)
+    {
+        return -1;
+    }
+    WishedBatch->Points[WishedBatch->NumPoints++] = (SDL_FPoint){x, y};
+    return 0;
+}
+
+bool FlushPointBatch(SDL_Renderer *Renderer, struct PointBatch *WishedBatch)
+{
+    bool result = true;
+    WishedBatch->PeakPoints = SDL_max(WishedBatch->PeakPoints, WishedBatch->NumPoints);
+    if (WishedBatch->NumPoints > 0)
+    {
+        result = SDL_RenderPoints(Renderer, WishedBatch->Points, WishedBatch->NumPoints);
+    }
+    WishedBatch->NumPoints = 0;
+    return result;
+}
+
+void ClearPointBatch(struct PointBatch *WishedBatch)
+{
+    if (WishedBatch->Arena == NULL)
+    {
+        SDL_free(WishedBatch->Points);
+    }
+    WishedBatch->Points = NULL;
+    WishedBatch->Capacity = 0;
+    WishedBatch->NumPoints = 0;
+}
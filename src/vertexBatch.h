@@ -0,0 +1,56 @@
+#ifndef VERTEXBATCH_H
+#define VERTEXBATCH_H
+
+#include <SDL3/SDL.h>
+
+#include "frameArena.h"
+
+/* A growable vertex/index buffer that collects triangles for a single SDL_RenderGeometry call.
+   Storage comes from a frame arena when one is bound, otherwise from the heap and is kept between frames. */
+struct VertexBatch
+{
+    struct FrameArena *Arena;
+    /* Largest size reached, reserved up front the next time the batch is bound */
+    int PeakVertices;
+    int PeakIndices;
+
+    int NumVertices;
+    int VertexCapacity;
+    SDL_Vertex *Vertices;
+
+    int NumIndices;
+    int IndexCapacity;
+    int *Indices;
+};
+
+/* A growable list of points for a single SDL_RenderPoints call*/
+struct PointBatch
+{
+    struct FrameArena *Arena;
+    int PeakPoints;
+
+    int NumPoints;
+    int Capacity;
+    SDL_FPoint *Points;
+};
+
+/* This function makes the batch take its storage from Arena for the current frame. Call it after every reset of the arena.*/
+void BindVertexBatch(struct VertexBatch *WishedBatch, struct FrameArena *Arena);
+/* This function makes room for more vertices and indices. Returns the index of the first new vertex, or -1 if the allocation fails.*/
+int ReserveVertexBatch(struct VertexBatch *WishedBatch, int NumVertices, int NumIndices);
+/* This function appends a quad from 4 vertices given in winding order. Returns -1 if the allocation fails.*/
+int AddQuadToBatch(struct VertexBatch *WishedBatch, const SDL_Vertex Corners[4]);
+/* This function submits everything collected so far in one call and empties the batch.*/
+bool FlushVertexBatch(SDL_Renderer *Renderer, struct VertexBatch *WishedBatch, SDL_Texture *Texture);
+void ResetVertexBatch(struct VertexBatch *WishedBatch);
+void ClearVertexBatch(struct VertexBatch *WishedBatch);
+
+/* This function makes the batch take its storage from Arena for the current frame. Call it after every reset of the arena.*/
+void BindPointBatch(struct PointBatch *WishedBatch, struct FrameArena *Arena);
+/* This function appends a point. Returns -1 if the allocation fails.*/
+int AddPointToBatch(struct PointBatch *WishedBatch, float x, float y);
+/* This function draws every collected point in the current draw color in one call and empties the batch.*/
+bool FlushPointBatch(SDL_Renderer *Renderer, struct PointBatch *WishedBatch);
+void ClearPointBatch(struct PointBatch *WishedBatch);
+
+#endif
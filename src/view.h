@@ -0,0 +1,16 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+/* The camera as seen by the renderers.
+   A world position maps to the screen as (Root - position) * Zoom. */
+struct View
+{
+    float RootX;
+    float RootY;
+    float Zoom;
+
+    int Width;
+    int Height;
+};
+
+#endif